@@ -42,17 +42,29 @@
  *     1       1.1.15   PCMK__ATTRD_CMD_UPDATE_BOTH,
  *                      PCMK__ATTRD_CMD_UPDATE_DELAY
  *     2       1.1.17   PCMK__ATTRD_CMD_CLEAR_FAILURE
+ *     3       2.0.4    PCMK__ATTRD_CMD_UPDATE_BULK
+ *     4       2.0.4    PCMK__ATTRD_CMD_SYNC_OFFER, PCMK__ATTRD_CMD_SYNC
+ *                      (with PCMK__XA_ATTR_IS_DELTA)
  */
-#define ATTRD_PROTOCOL_VERSION "2"
+#define ATTRD_PROTOCOL_VERSION "4"
+
+/* How long the writer waits for a peer to answer a sync offer before falling
+ * back to sending it the full attribute table
+ */
+#define ATTRD_SYNC_OFFER_TIMEOUT_MS 5000
 
 int last_cib_op_done = 0;
 GHashTable *attributes = NULL;
 
+// Peers offered a delta sync (node name -> fallback timer source ID)
+static GHashTable *sync_offers = NULL;
+
 void write_attribute(attribute_t *a, bool ignore_delay);
 void write_or_elect_attribute(attribute_t *a);
 void attrd_current_only_attribute_update(crm_node_t *peer, xmlNode *xml);
 void attrd_peer_update(crm_node_t *peer, xmlNode *xml, const char *host, bool filter);
 void attrd_peer_sync(crm_node_t *peer, xmlNode *xml);
+void attrd_request_sync(crm_node_t *peer);
 void attrd_peer_remove(const char *host, gboolean uncache, const char *source);
 
 static gboolean
@@ -123,7 +135,7 @@ build_attribute_xml(
 }
 
 static void
-clear_attribute_value_seen(void)
+set_attribute_value_seen(gboolean seen)
 {
     GHashTableIter aIter;
     GHashTableIter vIter;
@@ -134,8 +146,9 @@ clear_attribute_value_seen(void)
     while (g_hash_table_iter_next(&aIter, NULL, (gpointer *) & a)) {
         g_hash_table_iter_init(&vIter, a->values);
         while (g_hash_table_iter_next(&vIter, NULL, (gpointer *) & v)) {
-            v->seen = FALSE;
-            crm_trace("Clear seen flag %s[%s] = %s.", a->id, v->nodename, v->current);
+            v->seen = seen;
+            crm_trace("%s seen flag %s[%s] = %s.", (seen? "Set" : "Clear"),
+                      a->id, v->nodename, v->current);
         }
     }
 }
@@ -174,6 +187,7 @@ create_attribute(xmlNode *xml)
     }
 
     g_hash_table_replace(attributes, a->id, a);
+    attrd_index_failure_attr(a->id);
     return a;
 }
 
@@ -224,6 +238,154 @@ attrd_client_peer_remove(const char *client_name, xmlNode *xml)
     }
 }
 
+/*!
+ * \internal
+ * \brief Check whether all cluster members support an attrd protocol version
+ *
+ * Each pacemaker-attrd sets the private CRM_ATTR_PROTOCOL attribute for its
+ * node at start-up, so a member without a value is assumed to be older.
+ *
+ * \param[in] version  Protocol version to check
+ *
+ * \return TRUE if all active cluster members support \p version
+ */
+static bool
+attrd_peers_support_protocol(int version)
+{
+    GHashTableIter iter;
+    crm_node_t *peer = NULL;
+    attribute_t *a = g_hash_table_lookup(attributes, CRM_ATTR_PROTOCOL);
+
+    if (a == NULL) {
+        return FALSE;
+    }
+
+    g_hash_table_iter_init(&iter, crm_peer_cache);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &peer)) {
+        attribute_value_t *v = NULL;
+
+        if ((peer->uname == NULL)
+            || safe_str_neq(peer->state, CRM_NODE_MEMBER)) {
+            continue;
+        }
+        v = g_hash_table_lookup(a->values, peer->uname);
+        if ((v == NULL) || (crm_parse_int(v->current, "0") < version)) {
+            crm_trace("Peer %s does not support attrd protocol %d",
+                      peer->uname, version);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*!
+ * \internal
+ * \brief Fill in the details of a client update that peers need
+ *
+ * Add the local node as the target if none was given, and expand any value
+ * given using ++ or += notation.
+ *
+ * \param[in,out] xml   Update XML
+ * \param[in]     attr  Name of attribute being updated
+ */
+static void
+prepare_client_update(xmlNode *xml, const char *attr)
+{
+    attribute_t *a = NULL;
+    const char *host = crm_element_value(xml, PCMK__XA_ATTR_NODE_NAME);
+    const char *value = crm_element_value(xml, PCMK__XA_ATTR_VALUE);
+
+    if (host == NULL) {
+        crm_trace("Inferring host");
+        crm_xml_add(xml, PCMK__XA_ATTR_NODE_NAME, attrd_cluster->uname);
+        crm_xml_add_int(xml, PCMK__XA_ATTR_NODE_ID, attrd_cluster->nodeid);
+        host = crm_element_value(xml, PCMK__XA_ATTR_NODE_NAME);
+    }
+
+    a = g_hash_table_lookup(attributes, attr);
+
+    /* If value was specified using ++ or += notation, expand to real value */
+    if (value) {
+        if (attrd_value_needs_expansion(value)) {
+            int int_value;
+            attribute_value_t *v = NULL;
+
+            if (a) {
+                v = g_hash_table_lookup(a->values, host);
+            }
+            int_value = attrd_expand_value(value, (v? v->current : NULL));
+
+            crm_info("Expanded %s=%s to %d", attr, value, int_value);
+            crm_xml_add_int(xml, PCMK__XA_ATTR_VALUE, int_value);
+
+            /* Replacing the value frees the previous memory, so re-query it */
+            value = crm_element_value(xml, PCMK__XA_ATTR_VALUE);
+        }
+    }
+
+    crm_debug("Broadcasting %s[%s]=%s%s", attr, host, value,
+              (attrd_election_won()? " (writer)" : ""));
+}
+
+// Most recently used update patterns, compiled (pattern -> regex_t)
+static GHashTable *pattern_cache = NULL;
+
+#define ATTRD_PATTERN_CACHE_MAX 32
+
+static void
+free_pattern(gpointer data)
+{
+    regfree((regex_t *) data);
+    free(data);
+}
+
+/*!
+ * \internal
+ * \brief Get a compiled regular expression for an update pattern
+ *
+ * \param[in] pattern  Extended regular expression from client
+ *
+ * \return Compiled expression (owned by cache), or NULL if \p pattern is invalid
+ */
+static regex_t *
+compiled_pattern(const char *pattern)
+{
+    regex_t *r_patt = NULL;
+
+    if (pattern_cache == NULL) {
+        pattern_cache = g_hash_table_new_full(crm_str_hash, g_str_equal, free,
+                                              free_pattern);
+    }
+
+    r_patt = g_hash_table_lookup(pattern_cache, pattern);
+    if (r_patt != NULL) {
+        return r_patt;
+    }
+
+    r_patt = calloc(1, sizeof(regex_t));
+    CRM_ASSERT(r_patt != NULL);
+    if (regcomp(r_patt, pattern, REG_EXTENDED|REG_NOSUB)) {
+        free(r_patt);
+        return NULL;
+    }
+
+    // Clients normally use a handful of patterns, so a crude limit is enough
+    if (g_hash_table_size(pattern_cache) >= ATTRD_PATTERN_CACHE_MAX) {
+        g_hash_table_remove_all(pattern_cache);
+    }
+    g_hash_table_insert(pattern_cache, strdup(pattern), r_patt);
+    return r_patt;
+}
+
+void
+attrd_free_pattern_cache(void)
+{
+    if (pattern_cache != NULL) {
+        g_hash_table_destroy(pattern_cache);
+        pattern_cache = NULL;
+    }
+}
+
 /*!
  * \internal
  * \brief Respond to a client update request
@@ -235,8 +397,6 @@ attrd_client_peer_remove(const char *client_name, xmlNode *xml)
 void
 attrd_client_update(xmlNode *xml)
 {
-    attribute_t *a = NULL;
-    char *host = crm_element_value_copy(xml, PCMK__XA_ATTR_NODE_NAME);
     const char *attr = crm_element_value(xml, PCMK__XA_ATTR_NAME);
     const char *value = crm_element_value(xml, PCMK__XA_ATTR_VALUE);
     const char *regex = crm_element_value(xml, PCMK__XA_ATTR_PATTERN);
@@ -244,10 +404,10 @@ attrd_client_update(xmlNode *xml)
     /* If a regex was specified, broadcast a message for each match */
     if ((attr == NULL) && regex) {
         GHashTableIter aIter;
-        regex_t *r_patt = calloc(1, sizeof(regex_t));
+        regex_t *r_patt = compiled_pattern(regex);
 
         crm_debug("Setting %s to %s", regex, value);
-        if (regcomp(r_patt, regex, REG_EXTENDED|REG_NOSUB)) {
+        if (r_patt == NULL) {
             crm_err("Bad regex '%s' for update", regex);
 
         } else {
@@ -262,52 +422,68 @@ attrd_client_update(xmlNode *xml)
                 }
             }
         }
-
-        free(host);
-        regfree(r_patt);
-        free(r_patt);
         return;
 
     } else if (attr == NULL) {
         crm_err("Update request did not specify attribute or regular expression");
-        free(host);
         return;
     }
 
-    if (host == NULL) {
-        crm_trace("Inferring host");
-        host = strdup(attrd_cluster->uname);
-        crm_xml_add(xml, PCMK__XA_ATTR_NODE_NAME, host);
-        crm_xml_add_int(xml, PCMK__XA_ATTR_NODE_ID, attrd_cluster->nodeid);
-    }
-
-    a = g_hash_table_lookup(attributes, attr);
-
-    /* If value was specified using ++ or += notation, expand to real value */
-    if (value) {
-        if (attrd_value_needs_expansion(value)) {
-            int int_value;
-            attribute_value_t *v = NULL;
+    prepare_client_update(xml, attr);
+    send_attrd_message(NULL, xml); /* ends up at attrd_peer_message() */
+}
 
-            if (a) {
-                v = g_hash_table_lookup(a->values, host);
-            }
-            int_value = attrd_expand_value(value, (v? v->current : NULL));
+/*!
+ * \internal
+ * \brief Respond to a client request to update many attributes at once
+ *
+ * \param[in] xml  Root of request XML, with one child per attribute update
+ */
+void
+attrd_client_update_bulk(xmlNode *xml)
+{
+    const char *user = crm_element_value(xml, PCMK__XA_ATTR_USER);
+    bool bulk_ok = attrd_peers_support_protocol(3);
+    xmlNode *child = __xml_first_child(xml);
+    int count = 0;
+
+    while (child != NULL) {
+        xmlNode *next = __xml_next(child);
+        const char *attr = crm_element_value(child, PCMK__XA_ATTR_NAME);
+
+        if (attr == NULL) {
+            crm_err("Ignoring bulk update entry that does not specify attribute");
+            free_xml(child);
+            child = next;
+            continue;
+        }
 
-            crm_info("Expanded %s=%s to %d", attr, value, int_value);
-            crm_xml_add_int(xml, PCMK__XA_ATTR_VALUE, int_value);
+        /* Each entry is applied by attrd_peer_update(), which takes all
+         * details from the entry itself
+         */
+        if (crm_element_value(child, PCMK__XA_ATTR_DAMPENING)) {
+            crm_xml_add(child, PCMK__XA_TASK, PCMK__ATTRD_CMD_UPDATE_BOTH);
+        } else {
+            crm_xml_add(child, PCMK__XA_TASK, PCMK__ATTRD_CMD_UPDATE);
+        }
+#if ENABLE_ACL
+        crm_xml_add(child, PCMK__XA_ATTR_USER, user);
+#endif
+        prepare_client_update(child, attr);
 
-            /* Replacing the value frees the previous memory, so re-query it */
-            value = crm_element_value(xml, PCMK__XA_ATTR_VALUE);
+        if (!bulk_ok) {
+            // Some peers can't handle bulk updates, so send them individually
+            send_attrd_message(NULL, child);
         }
+        count++;
+        child = next;
     }
 
-    crm_debug("Broadcasting %s[%s]=%s%s", attr, host, value,
-              (attrd_election_won()? " (writer)" : ""));
-
-    free(host);
-
-    send_attrd_message(NULL, xml); /* ends up at attrd_peer_message() */
+    if (bulk_ok && (count > 0)) {
+        crm_debug("Broadcasting %d attribute update%s together",
+                  count, pcmk__plural_s(count));
+        send_attrd_message(NULL, xml); /* ends up at attrd_peer_message() */
+    }
 }
 
 /*!
@@ -335,41 +511,25 @@ attrd_client_clear_failure(xmlNode *xml)
     const char *rsc = crm_element_value(xml, PCMK__XA_ATTR_RESOURCE);
     const char *op = crm_element_value(xml, PCMK__XA_ATTR_OPERATION);
     const char *interval_spec = crm_element_value(xml, PCMK__XA_ATTR_INTERVAL);
+    guint interval_ms = crm_parse_interval_spec(interval_spec);
+    GList *names = attrd_failure_attrs(rsc, op, interval_ms);
 
     /* Map this to an update */
     crm_xml_add(xml, PCMK__XA_TASK, PCMK__ATTRD_CMD_UPDATE);
 
-    /* Add regular expression matching desired attributes */
-
-    if (rsc) {
-        char *pattern;
-
-        if (op == NULL) {
-            pattern = crm_strdup_printf(ATTRD_RE_CLEAR_ONE, rsc);
-
-        } else {
-            guint interval_ms = crm_parse_interval_spec(interval_spec);
-
-            pattern = crm_strdup_printf(ATTRD_RE_CLEAR_OP,
-                                        rsc, op, interval_ms);
-        }
-
-        crm_xml_add(xml, PCMK__XA_ATTR_PATTERN, pattern);
-        free(pattern);
-
-    } else {
-        crm_xml_add(xml, PCMK__XA_ATTR_PATTERN, ATTRD_RE_CLEAR_ALL);
-    }
-
-    /* Make sure attribute and value are not set, so we delete via regex */
-    if (crm_element_value(xml, PCMK__XA_ATTR_NAME)) {
-        crm_xml_replace(xml, PCMK__XA_ATTR_NAME, NULL);
-    }
+    /* Make sure value is not set, so we delete */
     if (crm_element_value(xml, PCMK__XA_ATTR_VALUE)) {
         crm_xml_replace(xml, PCMK__XA_ATTR_VALUE, NULL);
     }
 
-    attrd_client_update(xml);
+    /* Broadcast a deletion for each matching attribute */
+    crm_debug("Clearing %d failure attributes for %s",
+              g_list_length(names), (rsc? rsc : "all resources"));
+    for (GList *iter = names; iter != NULL; iter = iter->next) {
+        crm_xml_add(xml, PCMK__XA_ATTR_NAME, (const char *) iter->data);
+        send_attrd_message(NULL, xml);
+    }
+    g_list_free(names);
 }
 
 /*!
@@ -519,15 +679,7 @@ attrd_peer_clear_failure(crm_node_t *peer, xmlNode *xml)
     const char *op = crm_element_value(xml, PCMK__XA_ATTR_OPERATION);
     const char *interval_spec = crm_element_value(xml, PCMK__XA_ATTR_INTERVAL);
     guint interval_ms = crm_parse_interval_spec(interval_spec);
-    char *attr = NULL;
-    GHashTableIter iter;
-    regex_t regex;
-
-    if (attrd_failure_regex(&regex, rsc, op, interval_ms) != pcmk_ok) {
-        crm_info("Ignoring invalid request to clear failures for %s",
-                 (rsc? rsc : "all resources"));
-        return;
-    }
+    GList *names = attrd_failure_attrs(rsc, op, interval_ms);
 
     crm_xml_add(xml, PCMK__XA_TASK, PCMK__ATTRD_CMD_UPDATE);
 
@@ -536,16 +688,15 @@ attrd_peer_clear_failure(crm_node_t *peer, xmlNode *xml)
         crm_xml_replace(xml, PCMK__XA_ATTR_VALUE, NULL);
     }
 
-    g_hash_table_iter_init(&iter, attributes);
-    while (g_hash_table_iter_next(&iter, (gpointer *) &attr, NULL)) {
-        if (regexec(&regex, attr, 0, NULL, 0) == 0) {
-            crm_trace("Matched %s when clearing %s",
-                      attr, (rsc? rsc : "all resources"));
-            crm_xml_add(xml, PCMK__XA_ATTR_NAME, attr);
-            attrd_peer_update(peer, xml, host, FALSE);
-        }
+    for (GList *iter = names; iter != NULL; iter = iter->next) {
+        const char *attr = iter->data;
+
+        crm_trace("Matched %s when clearing %s",
+                  attr, (rsc? rsc : "all resources"));
+        crm_xml_add(xml, PCMK__XA_ATTR_NAME, attr);
+        attrd_peer_update(peer, xml, host, FALSE);
     }
-    regfree(&regex);
+    g_list_free(names);
 }
 
 /*!
@@ -595,9 +746,22 @@ attrd_peer_message(crm_node_t *peer, xmlNode *xml)
         || safe_str_eq(op, PCMK__ATTRD_CMD_UPDATE_DELAY)) {
         attrd_peer_update(peer, xml, host, FALSE);
 
+    } else if (safe_str_eq(op, PCMK__ATTRD_CMD_UPDATE_BULK)) {
+        xmlNode *child = NULL;
+
+        for (child = __xml_first_child(xml); child != NULL;
+             child = __xml_next(child)) {
+            host = crm_element_value(child, PCMK__XA_ATTR_NODE_NAME);
+            attrd_peer_update(peer, child, host, FALSE);
+        }
+
     } else if (safe_str_eq(op, PCMK__ATTRD_CMD_SYNC)) {
         attrd_peer_sync(peer, xml);
 
+    } else if (safe_str_eq(op, PCMK__ATTRD_CMD_SYNC_OFFER)
+              && safe_str_neq(peer->uname, attrd_cluster->uname)) {
+        attrd_request_sync(peer);
+
     } else if (safe_str_eq(op, PCMK__ATTRD_CMD_PEER_REMOVE)) {
         attrd_peer_remove(host, TRUE, peer->uname);
 
@@ -610,16 +774,35 @@ attrd_peer_message(crm_node_t *peer, xmlNode *xml)
     } else if (safe_str_eq(op, PCMK__ATTRD_CMD_SYNC_RESPONSE)
               && safe_str_neq(peer->uname, attrd_cluster->uname)) {
         xmlNode *child = NULL;
+        int is_delta = 0;
 
-        crm_info("Processing %s from %s", op, peer->uname);
+        crm_element_value_int(xml, PCMK__XA_ATTR_IS_DELTA, &is_delta);
+        crm_info("Processing %s%s from %s",
+                 (is_delta? "delta " : ""), op, peer->uname);
 
-        /* Clear the seen flag for attribute processing held only in the own node. */
+        /* Clear the seen flag for attribute processing held only in the own
+         * node. A delta response omits values we already agree on, and
+         * instead explicitly lists the local values the writer lacks.
+         */
         if (peer_won) {
-            clear_attribute_value_seen();
+            set_attribute_value_seen(is_delta != 0);
         }
 
         for (child = __xml_first_child(xml); child != NULL; child = __xml_next(child)) {
+            int is_absent = 0;
+
             host = crm_element_value(child, PCMK__XA_ATTR_NODE_NAME);
+            crm_element_value_int(child, PCMK__XA_ATTR_IS_ABSENT, &is_absent);
+            if (is_absent) {
+                attribute_t *a = g_hash_table_lookup(attributes,
+                                                     crm_element_value(child, PCMK__XA_ATTR_NAME));
+                attribute_value_t *v = NULL;
+
+                if (a && host && (v = g_hash_table_lookup(a->values, host))) {
+                    v->seen = FALSE;
+                }
+                continue;
+            }
             attrd_peer_update(peer, child, host, TRUE);
         }
 
@@ -630,6 +813,120 @@ attrd_peer_message(crm_node_t *peer, xmlNode *xml)
     }
 }
 
+/*!
+ * \internal
+ * \brief Get a digest of an attribute value for sync comparisons
+ *
+ * \param[in] value  Attribute value (may be NULL)
+ *
+ * \return Newly allocated MD5 digest of \p value (or NULL if \p value is NULL)
+ */
+static char *
+value_digest(const char *value)
+{
+    return (value == NULL)? NULL : crm_md5sum(value);
+}
+
+static char *
+sync_key(const char *name, const char *host)
+{
+    // Node names can't contain spaces, so this is unambiguous
+    return crm_strdup_printf("%s %s", host, name);
+}
+
+/*!
+ * \internal
+ * \brief Index the values listed in a delta sync request
+ *
+ * \param[in] xml  Sync request from peer
+ *
+ * \return Table of request entries keyed by sync_key(), or NULL if the request
+ *         is not a delta request (and so wants all values)
+ */
+static GHashTable *
+index_sync_request(xmlNode *xml)
+{
+    GHashTable *known = NULL;
+    int is_delta = 0;
+
+    crm_element_value_int(xml, PCMK__XA_ATTR_IS_DELTA, &is_delta);
+    if (!is_delta) {
+        return NULL;
+    }
+
+    known = g_hash_table_new_full(crm_str_hash, g_str_equal, free, NULL);
+    for (xmlNode *child = __xml_first_child(xml); child != NULL;
+         child = __xml_next(child)) {
+
+        const char *name = crm_element_value(child, PCMK__XA_ATTR_NAME);
+        const char *host = crm_element_value(child, PCMK__XA_ATTR_NODE_NAME);
+
+        if (name && host) {
+            g_hash_table_replace(known, sync_key(name, host), child);
+        }
+    }
+    return known;
+}
+
+/*!
+ * \internal
+ * \brief Check whether a peer already has the same version of a value
+ *
+ * \param[in] known  Index of peer's values as returned by index_sync_request()
+ * \param[in] a      Attribute to check
+ * \param[in] v      Local value of attribute to check
+ *
+ * \return TRUE if peer reported the same version and value digest
+ * \note Any entry for the value is removed from \p known.
+ */
+static bool
+peer_has_value(GHashTable *known, attribute_t *a, attribute_value_t *v)
+{
+    char *key = sync_key(a->id, v->nodename);
+    xmlNode *entry = g_hash_table_lookup(known, key);
+    bool same = FALSE;
+
+    if (entry != NULL) {
+        long long version = -1;
+
+        crm_element_value_ll(entry, PCMK__XA_ATTR_VALUE_VERSION, &version);
+        if (version == v->version) {
+            char *digest = value_digest(v->current);
+
+            same = crm_str_eq(crm_element_value(entry,
+                                                PCMK__XA_ATTR_VALUE_DIGEST),
+                              digest, TRUE);
+            free(digest);
+        }
+        g_hash_table_remove(known, key);
+    }
+    free(key);
+    return same;
+}
+
+static void
+cancel_sync_offer(const char *host)
+{
+    gpointer source = NULL;
+
+    if (sync_offers && host
+        && g_hash_table_lookup_extended(sync_offers, host, NULL, &source)) {
+        g_source_remove(GPOINTER_TO_UINT(source));
+        g_hash_table_remove(sync_offers, host);
+    }
+}
+
+/*!
+ * \internal
+ * \brief Send attribute values to a peer (or all peers)
+ *
+ * \param[in] peer  Peer to sync (or NULL for all peers)
+ * \param[in] xml   Sync request from \p peer (or NULL if not requested)
+ *
+ * \note If the request lists the values that the peer already has, only values
+ *       that differ are sent, along with the peer's own values that are
+ *       unknown locally (so the peer can broadcast them).
+ */
 void
 attrd_peer_sync(crm_node_t *peer, xmlNode *xml)
 {
@@ -638,25 +935,171 @@ attrd_peer_sync(crm_node_t *peer, xmlNode *xml)
 
     attribute_t *a = NULL;
     attribute_value_t *v = NULL;
+    GHashTable *known = NULL;
+    int sent = 0;
+    int skipped = 0;
     xmlNode *sync = create_xml_node(NULL, __FUNCTION__);
 
     crm_xml_add(sync, PCMK__XA_TASK, PCMK__ATTRD_CMD_SYNC_RESPONSE);
 
+    if (peer != NULL) {
+        cancel_sync_offer(peer->uname);
+        if (xml != NULL) {
+            known = index_sync_request(xml);
+        }
+    }
+    if (known != NULL) {
+        crm_xml_add_int(sync, PCMK__XA_ATTR_IS_DELTA, 1);
+    }
+
     g_hash_table_iter_init(&aIter, attributes);
     while (g_hash_table_iter_next(&aIter, NULL, (gpointer *) & a)) {
         g_hash_table_iter_init(&vIter, a->values);
         while (g_hash_table_iter_next(&vIter, NULL, (gpointer *) & v)) {
+            xmlNode *entry = NULL;
+
+            if (known && peer_has_value(known, a, v)) {
+                skipped++;
+                continue;
+            }
             crm_debug("Syncing %s[%s] = %s to %s", a->id, v->nodename, v->current, peer?peer->uname:"everyone");
-            build_attribute_xml(sync, a->id, a->set, a->uuid, a->timeout_ms, a->user, a->is_private,
-                                v->nodename, v->nodeid, v->current, FALSE);
+            entry = build_attribute_xml(sync, a->id, a->set, a->uuid, a->timeout_ms, a->user, a->is_private,
+                                        v->nodename, v->nodeid, v->current, FALSE);
+            crm_xml_add_ll(entry, PCMK__XA_ATTR_VALUE_VERSION, v->version);
+            sent++;
         }
     }
 
-    crm_debug("Syncing values to %s", peer?peer->uname:"everyone");
+    if (known != NULL) {
+        GHashTableIter kIter;
+        xmlNode *request = NULL;
+
+        // Whatever is left are values we don't have
+        g_hash_table_iter_init(&kIter, known);
+        while (g_hash_table_iter_next(&kIter, NULL, (gpointer *) &request)) {
+            const char *host = crm_element_value(request, PCMK__XA_ATTR_NODE_NAME);
+            xmlNode *entry = NULL;
+
+            // Only the peer's own values are of interest to it
+            if (safe_str_neq(host, peer->uname)) {
+                continue;
+            }
+            entry = create_xml_node(sync, __FUNCTION__);
+            crm_xml_add(entry, PCMK__XA_ATTR_NAME,
+                        crm_element_value(request, PCMK__XA_ATTR_NAME));
+            crm_xml_add(entry, PCMK__XA_ATTR_NODE_NAME, host);
+            crm_xml_add_int(entry, PCMK__XA_ATTR_IS_ABSENT, 1);
+        }
+        g_hash_table_destroy(known);
+    }
+
+    crm_debug("Syncing %d values to %s (%d already current)",
+              sent, (peer? peer->uname : "everyone"), skipped);
     send_attrd_message(peer, sync);
     free_xml(sync);
 }
 
+/*!
+ * \internal
+ * \brief Answer a writer's sync offer with the versions of all known values
+ *
+ * \param[in] peer  Writer that sent the offer
+ */
+void
+attrd_request_sync(crm_node_t *peer)
+{
+    GHashTableIter aIter;
+    GHashTableIter vIter;
+
+    attribute_t *a = NULL;
+    attribute_value_t *v = NULL;
+    xmlNode *request = create_xml_node(NULL, __FUNCTION__);
+
+    crm_xml_add(request, PCMK__XA_TASK, PCMK__ATTRD_CMD_SYNC);
+    crm_xml_add_int(request, PCMK__XA_ATTR_IS_DELTA, 1);
+
+    g_hash_table_iter_init(&aIter, attributes);
+    while (g_hash_table_iter_next(&aIter, NULL, (gpointer *) & a)) {
+        g_hash_table_iter_init(&vIter, a->values);
+        while (g_hash_table_iter_next(&vIter, NULL, (gpointer *) & v)) {
+            xmlNode *entry = create_xml_node(request, __FUNCTION__);
+            char *digest = value_digest(v->current);
+
+            crm_xml_add(entry, PCMK__XA_ATTR_NAME, a->id);
+            crm_xml_add(entry, PCMK__XA_ATTR_NODE_NAME, v->nodename);
+            crm_xml_add_ll(entry, PCMK__XA_ATTR_VALUE_VERSION, v->version);
+            crm_xml_add(entry, PCMK__XA_ATTR_VALUE_DIGEST, digest);
+            free(digest);
+        }
+    }
+
+    crm_debug("Requesting changed values from %s", peer->uname);
+    send_attrd_message(peer, request);
+    free_xml(request);
+}
+
+static gboolean
+sync_offer_timeout_cb(gpointer data)
+{
+    const char *host = data;
+    crm_node_t *peer = crm_find_peer(0, host);
+
+    // Returning FALSE removes the source, so just forget it
+    g_hash_table_remove(sync_offers, host);
+
+    if (peer && safe_str_eq(peer->state, CRM_NODE_MEMBER)
+        && attrd_election_won()) {
+        crm_info("%s did not answer sync offer, sending all values", host);
+        attrd_peer_sync(peer, NULL);
+    }
+    return FALSE;
+}
+
+/*!
+ * \internal
+ * \brief Bring a new peer up to date with the attribute table
+ *
+ * If the peer was last known to support delta syncs, offer it one, falling
+ * back to sending all values if it does not answer in time. Otherwise, send it
+ * all values immediately.
+ *
+ * \param[in] peer  Peer that joined
+ */
+static void
+attrd_offer_sync(crm_node_t *peer)
+{
+    attribute_t *a = g_hash_table_lookup(attributes, CRM_ATTR_PROTOCOL);
+    attribute_value_t *v = NULL;
+    xmlNode *offer = NULL;
+    guint source = 0;
+
+    if (a != NULL) {
+        v = g_hash_table_lookup(a->values, peer->uname);
+    }
+    if ((v == NULL) || (crm_parse_int(v->current, "0") < 4)) {
+        attrd_peer_sync(peer, NULL);
+        return;
+    }
+
+    if (sync_offers == NULL) {
+        sync_offers = g_hash_table_new_full(crm_str_hash, g_str_equal, free,
+                                            NULL);
+    }
+    cancel_sync_offer(peer->uname);
+
+    offer = create_xml_node(NULL, __FUNCTION__);
+    crm_xml_add(offer, PCMK__XA_TASK, PCMK__ATTRD_CMD_SYNC_OFFER);
+    crm_debug("Offering delta sync to %s", peer->uname);
+    send_attrd_message(peer, offer);
+    free_xml(offer);
+
+    source = g_timeout_add_full(G_PRIORITY_DEFAULT, ATTRD_SYNC_OFFER_TIMEOUT_MS,
+                                sync_offer_timeout_cb, strdup(peer->uname),
+                                free);
+    g_hash_table_insert(sync_offers, strdup(peer->uname),
+                        GUINT_TO_POINTER(source));
+}
+
 /*!
  * \internal
  * \brief Remove all attributes and optionally peer cache entries for a node
@@ -676,12 +1119,19 @@ attrd_peer_remove(const char *host, gboolean uncache, const char *source)
 
     g_hash_table_iter_init(&aIter, attributes);
     while (g_hash_table_iter_next(&aIter, NULL, (gpointer *) & a)) {
+        /* Remember a lost peer's protocol version, so we know whether it can
+         * take a delta sync when it rejoins
+         */
+        if (!uncache && safe_str_eq(a->id, CRM_ATTR_PROTOCOL)) {
+            continue;
+        }
         if(g_hash_table_remove(a->values, host)) {
             crm_debug("Removed %s[%s] for peer %s", a->id, host, source);
         }
     }
 
     if (uncache) {
+        cancel_sync_offer(host);
         crm_remote_peer_cache_remove(host);
         reap_crm_member(0, host);
     }
@@ -883,6 +1333,7 @@ attrd_peer_update(crm_node_t *peer, xmlNode *xml, const char *host, bool filter)
                    attr, host, v->current? v->current : "(unset)", value? value : "(unset)", peer->uname);
         free(v->current);
         v->current = (value? strdup(value) : NULL);
+        v->version++;
         a->changed = TRUE;
 
         // Write out new value or start dampening timer
@@ -907,6 +1358,18 @@ attrd_peer_update(crm_node_t *peer, xmlNode *xml, const char *host, bool filter)
     /* Set the seen flag for attribute processing held only in the own node. */
     v->seen = TRUE;
 
+    /* Adopt the sender's version of values it synchronized to us, so later
+     * delta syncs can compare versions
+     */
+    if (safe_str_eq(v->current, value)) {
+        long long version = 0;
+
+        if (crm_element_value_ll(xml, PCMK__XA_ATTR_VALUE_VERSION,
+                                 &version) == 0) {
+            v->version = (unsigned int) version;
+        }
+    }
+
     /* If this is a cluster node whose node ID we are learning, remember it */
     if ((v->nodeid == 0) && (v->is_remote == FALSE)
         && (crm_element_value_int(xml, PCMK__XA_ATTR_NODE_ID,
@@ -968,7 +1431,7 @@ attrd_peer_change_cb(enum crm_status_type kind, crm_node_t *peer, const void *da
                  */
                 if (attrd_election_won()
                     && !is_set(peer->flags, crm_remote_node)) {
-                    attrd_peer_sync(peer, NULL);
+                    attrd_offer_sync(peer);
                 }
             } else {
                 // Remove all attribute values associated with lost nodes
@@ -984,15 +1447,21 @@ attrd_peer_change_cb(enum crm_status_type kind, crm_node_t *peer, const void *da
     }
 }
 
+/*!
+ * \internal
+ * \brief Process the result of a CIB write for one attribute
+ *
+ * \param[in] name     Name of attribute that was written
+ * \param[in] call_id  CIB call ID of the write
+ * \param[in] rc       Legacy return code of the write
+ * \param[in] level    Log level to use for the result
+ */
 static void
-attrd_cib_callback(xmlNode * msg, int call_id, int rc, xmlNode * output, void *user_data)
+attrd_cib_result(const char *name, int call_id, int rc, int level)
 {
-    int level = LOG_ERR;
     GHashTableIter iter;
     const char *peer = NULL;
     attribute_value_t *v = NULL;
-
-    char *name = user_data;
     attribute_t *a = g_hash_table_lookup(attributes, name);
 
     if(a == NULL) {
@@ -1001,28 +1470,10 @@ attrd_cib_callback(xmlNode * msg, int call_id, int rc, xmlNode * output, void *u
     }
 
     a->update = 0;
-    if (rc == pcmk_ok && call_id < 0) {
-        rc = call_id;
-    }
-
-    switch (rc) {
-        case pcmk_ok:
-            level = LOG_INFO;
-            last_cib_op_done = call_id;
-            if (a->timer && !a->timeout_ms) {
-                // Remove temporary dampening for failed writes
-                mainloop_timer_del(a->timer);
-                a->timer = NULL;
-            }
-            break;
-
-        case -pcmk_err_diff_failed:    /* When an attr changes while the CIB is syncing */
-        case -ETIME:           /* When an attr changes while there is a DC election */
-        case -ENXIO:           /* When an attr changes while the CIB is syncing a
-                                *   newer config from a node that just came up
-                                */
-            level = LOG_WARNING;
-            break;
+    if ((rc == pcmk_ok) && a->timer && !a->timeout_ms) {
+        // Remove temporary dampening for failed writes
+        mainloop_timer_del(a->timer);
+        a->timer = NULL;
     }
 
     do_crm_log(level, "CIB update %d result for %s: %s " CRM_XS " rc=%d",
@@ -1073,6 +1524,56 @@ attrd_cib_callback(xmlNode * msg, int call_id, int rc, xmlNode * output, void *u
     }
 }
 
+static void
+attrd_cib_callback(xmlNode * msg, int call_id, int rc, xmlNode * output, void *user_data)
+{
+    int level = LOG_ERR;
+    GList *names = user_data;
+    bool combined = (names != NULL) && (names->next != NULL);
+
+    if (rc == pcmk_ok && call_id < 0) {
+        rc = call_id;
+    }
+
+    switch (rc) {
+        case pcmk_ok:
+            level = LOG_INFO;
+            last_cib_op_done = call_id;
+            break;
+
+        case -pcmk_err_diff_failed:    /* When an attr changes while the CIB is syncing */
+        case -ETIME:           /* When an attr changes while there is a DC election */
+        case -ENXIO:           /* When an attr changes while the CIB is syncing a
+                                *   newer config from a node that just came up
+                                */
+            level = LOG_WARNING;
+            break;
+    }
+
+    for (GList *iter = names; iter != NULL; iter = iter->next) {
+        attribute_t *a = g_hash_table_lookup(attributes, iter->data);
+
+        /* Any one attribute could have made a combined write fail, so after a
+         * failure, write each separately until it succeeds, so one bad
+         * attribute can't keep the others from being written.
+         */
+        if (a != NULL) {
+            if (rc == pcmk_ok) {
+                a->write_alone = FALSE;
+            } else if (combined) {
+                a->write_alone = TRUE;
+            }
+        }
+        attrd_cib_result((const char *) iter->data, call_id, rc, level);
+    }
+}
+
+static void
+free_name_list(void *data)
+{
+    g_list_free_full((GList *) data, free);
+}
+
 void
 write_attributes(bool all, bool ignore_delay)
 {
@@ -1099,32 +1600,63 @@ write_attributes(bool all, bool ignore_delay)
     }
 }
 
+/*!
+ * \internal
+ * \brief Find a child element with a given ID, creating it if needed
+ *
+ * \param[in] parent  Element to search
+ * \param[in] name    Name of child element
+ * \param[in] id      ID of child element (will be sanitized)
+ *
+ * \return Matching child element
+ */
+static xmlNode *
+update_child(xmlNode *parent, const char *name, char *id)
+{
+    xmlNode *child = NULL;
+
+    crm_xml_sanitize_id(id);
+    child = find_entity(parent, name, id);
+    if (child == NULL) {
+        child = create_xml_node(parent, name);
+        crm_xml_add(child, XML_ATTR_ID, id);
+    }
+    return child;
+}
+
 static void
 build_update_element(xmlNode *parent, attribute_t *a, const char *nodeid, const char *value)
 {
-    const char *set = NULL;
+    char *id = NULL;
     xmlNode *xml_obj = NULL;
 
-    xml_obj = create_xml_node(parent, XML_CIB_TAG_STATE);
-    crm_xml_add(xml_obj, XML_ATTR_ID, nodeid);
-
-    xml_obj = create_xml_node(xml_obj, XML_TAG_TRANSIENT_NODEATTRS);
-    crm_xml_add(xml_obj, XML_ATTR_ID, nodeid);
+    /* Several attributes may be written in one update, so reuse any state
+     * and set elements already added for this node
+     */
+    id = strdup(nodeid);
+    xml_obj = update_child(parent, XML_CIB_TAG_STATE, id);
+    xml_obj = update_child(xml_obj, XML_TAG_TRANSIENT_NODEATTRS, id);
+    free(id);
 
-    xml_obj = create_xml_node(xml_obj, XML_TAG_ATTR_SETS);
     if (a->set) {
-        crm_xml_set_id(xml_obj, "%s", a->set);
+        id = strdup(a->set);
     } else {
-        crm_xml_set_id(xml_obj, "%s-%s", XML_CIB_TAG_STATUS, nodeid);
+        id = crm_strdup_printf("%s-%s", XML_CIB_TAG_STATUS, nodeid);
     }
-    set = ID(xml_obj);
+    xml_obj = update_child(xml_obj, XML_TAG_ATTR_SETS, id);
 
-    xml_obj = create_xml_node(xml_obj, XML_CIB_TAG_NVPAIR);
     if (a->uuid) {
-        crm_xml_set_id(xml_obj, "%s", a->uuid);
+        free(id);
+        id = strdup(a->uuid);
     } else {
-        crm_xml_set_id(xml_obj, "%s-%s", set, a->id);
+        char *set = id;
+
+        id = crm_strdup_printf("%s-%s", set, a->id);
+        free(set);
     }
+    xml_obj = update_child(xml_obj, XML_CIB_TAG_NVPAIR, id);
+    free(id);
+
     crm_xml_add(xml_obj, XML_NVPAIR_ATTR_NAME, a->id);
 
     if(value) {
@@ -1170,20 +1702,95 @@ send_alert_attributes_value(attribute_t *a, GHashTable *t)
     }
 }
 
-void
-write_attribute(attribute_t *a, bool ignore_delay)
+/* Attributes are not written to the CIB as soon as they change. Instead, they
+ * are marked as pending, and at the next main loop iteration, all pending
+ * attributes are written together in a single status section update per ACL
+ * user, so a burst of changes (such as a refresh or a peer's sync response)
+ * costs one CIB round trip instead of one per attribute.
+ */
+static GHashTable *pending_writes = NULL; // Name -> whether to ignore delay
+static crm_trigger_t *write_trigger = NULL;
+
+// Attributes to be written by a single CIB update
+typedef struct attrd_cib_batch_s {
+    const char *user;               // ACL user to write as (not owned)
+    xmlNode *xml;                   // Status section update
+    GList *names;                   // Names of attributes in update
+    int changes;                    // Number of values in update
+    enum cib_call_options flags;    // CIB call options for update
+    bool alone;                     // Whether update is for one attribute only
+} attrd_cib_batch_t;
+
+/*!
+ * \internal
+ * \brief Find (or create) the CIB update that an attribute should be added to
+ *
+ * Attributes are combined only if they are written as the same user with the
+ * same call options, so that one attribute's options never apply to others.
+ *
+ * \param[in,out] batches  CIB updates being built
+ * \param[in]     a        Attribute to be written
+ * \param[in]     flags    CIB call options that attribute's write needs
+ *
+ * \return CIB update to add attribute to
+ */
+static attrd_cib_batch_t *
+find_batch(GList **batches, attribute_t *a, enum cib_call_options flags)
+{
+    attrd_cib_batch_t *batch = NULL;
+
+    for (GList *iter = *batches; !a->write_alone && (iter != NULL);
+         iter = iter->next) {
+        batch = iter->data;
+        if (!batch->alone && (batch->flags == flags)
+            && safe_str_eq(batch->user, a->user)) {
+            return batch;
+        }
+    }
+
+    batch = calloc(1, sizeof(attrd_cib_batch_t));
+    CRM_ASSERT(batch != NULL);
+    batch->user = a->user;
+    batch->xml = create_xml_node(NULL, XML_CIB_TAG_STATUS);
+    batch->flags = flags;
+    batch->alone = a->write_alone;
+    *batches = g_list_append(*batches, batch);
+    return batch;
+}
+
+// Whether any of an attribute's values are to be deleted
+static bool
+attribute_has_deletion(attribute_t *a)
+{
+    GHashTableIter iter;
+    attribute_value_t *v = NULL;
+
+    g_hash_table_iter_init(&iter, a->values);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &v)) {
+        if (v->current == NULL) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*!
+ * \internal
+ * \brief Add an attribute's values to the appropriate CIB update
+ *
+ * \param[in]     a             Attribute to write
+ * \param[in]     ignore_delay  If TRUE, write even if dampening is in effect
+ * \param[in,out] batches       CIB updates being built
+ */
+static void
+add_attribute_to_batch(attribute_t *a, bool ignore_delay, GList **batches)
 {
     int private_updates = 0, cib_updates = 0;
-    xmlNode *xml_top = NULL;
+    attrd_cib_batch_t *batch = NULL;
     attribute_value_t *v = NULL;
     GHashTableIter iter;
-    enum cib_call_options flags = cib_quorum_override;
     GHashTable *alert_attribute_value = NULL;
 
-    if (a == NULL) {
-        return;
-    }
-
     /* If this attribute will be written to the CIB ... */
     if (!a->is_private) {
 
@@ -1210,8 +1817,15 @@ write_attribute(attribute_t *a, bool ignore_delay)
             }
         }
 
-        /* Initialize the status update XML */
-        xml_top = create_xml_node(NULL, XML_CIB_TAG_STATUS);
+        if (attribute_has_deletion(a)) {
+            /* Older attrd versions don't know about the cib_mixed_update
+             * flag so make sure it goes to the local cib which does
+             */
+            batch = find_batch(batches, a, cib_quorum_override
+                                           |cib_mixed_update|cib_scope_local);
+        } else {
+            batch = find_batch(batches, a, cib_quorum_override);
+        }
     }
 
     /* Attribute will be written shortly, so clear changed flag */
@@ -1265,7 +1879,7 @@ write_attribute(attribute_t *a, bool ignore_delay)
         crm_debug("Updating %s[%s]=%s (peer known as %s, UUID %s, ID %u/%u)",
                   a->id, v->nodename, v->current,
                   peer->uname, peer->uuid, peer->id, v->nodeid);
-        build_update_element(xml_top, a, peer->uuid, v->current);
+        build_update_element(batch->xml, a, peer->uuid, v->current);
         cib_updates++;
 
         /* Preservation of the attribute to transmit alert */
@@ -1275,11 +1889,6 @@ write_attribute(attribute_t *a, bool ignore_delay)
         v->requested = NULL;
         if (v->current) {
             v->requested = strdup(v->current);
-        } else {
-            /* Older attrd versions don't know about the cib_mixed_update
-             * flag so make sure it goes to the local cib which does
-             */
-            flags |= cib_mixed_update|cib_scope_local;
         }
     }
 
@@ -1289,24 +1898,116 @@ write_attribute(attribute_t *a, bool ignore_delay)
                  a->id, (a->uuid? a->uuid : "n/a"), (a->set? a->set : "n/a"));
     }
     if (cib_updates) {
-        crm_log_xml_trace(xml_top, __FUNCTION__);
+        crm_debug("Queued %d change%s for %s (id %s, set %s)",
+                  cib_updates, pcmk__plural_s(cib_updates),
+                  a->id, (a->uuid? a->uuid : "n/a"), (a->set? a->set : "n/a"));
+        batch->names = g_list_prepend(batch->names, strdup(a->id));
+        batch->changes += cib_updates;
 
-        a->update = cib_internal_op(the_cib, CIB_OP_MODIFY, NULL, XML_CIB_TAG_STATUS, xml_top, NULL,
-                                    flags, a->user);
+        /* Transmit alert of the attribute */
+        send_alert_attributes_value(a, alert_attribute_value);
+    }
 
-        crm_info("Sent CIB request %d with %d change%s for %s (id %s, set %s)",
-                 a->update, cib_updates, pcmk__plural_s(cib_updates),
-                 a->id, (a->uuid? a->uuid : "n/a"), (a->set? a->set : "n/a"));
+    g_hash_table_destroy(alert_attribute_value);
+}
 
-        the_cib->cmds->register_callback_full(the_cib, a->update,
+/*!
+ * \internal
+ * \brief Send a CIB update for a batch of attributes, then free the batch
+ *
+ * \param[in] data  Batch to send
+ */
+static void
+send_batch(gpointer data)
+{
+    attrd_cib_batch_t *batch = data;
+    int call_id = 0;
+
+    if (batch->changes > 0) {
+        crm_log_xml_trace(batch->xml, __FUNCTION__);
+
+        call_id = cib_internal_op(the_cib, CIB_OP_MODIFY, NULL,
+                                  XML_CIB_TAG_STATUS, batch->xml, NULL,
+                                  batch->flags, batch->user);
+
+        crm_info("Sent CIB request %d with %d change%s for %d attribute%s",
+                 call_id, batch->changes, pcmk__plural_s(batch->changes),
+                 g_list_length(batch->names),
+                 pcmk__plural_s(g_list_length(batch->names)));
+
+        for (GList *iter = batch->names; iter != NULL; iter = iter->next) {
+            attribute_t *a = g_hash_table_lookup(attributes, iter->data);
+
+            if (a != NULL) {
+                a->update = call_id;
+            }
+        }
+
+        // The callback takes ownership of the name list
+        the_cib->cmds->register_callback_full(the_cib, call_id,
                                               CIB_OP_TIMEOUT_S, FALSE,
-                                              strdup(a->id),
+                                              batch->names,
                                               "attrd_cib_callback",
-                                              attrd_cib_callback, free);
-        /* Transmit alert of the attribute */
-        send_alert_attributes_value(a, alert_attribute_value);
+                                              attrd_cib_callback,
+                                              free_name_list);
+        batch->names = NULL;
     }
 
-    g_hash_table_destroy(alert_attribute_value);
-    free_xml(xml_top);
+    g_list_free_full(batch->names, free);
+    free_xml(batch->xml);
+    free(batch);
+}
+
+/*!
+ * \internal
+ * \brief Write all pending attributes to the CIB
+ *
+ * \param[in] user_data  Ignored
+ *
+ * \return TRUE (to keep the trigger)
+ */
+static gboolean
+write_pending_attributes(gpointer user_data)
+{
+    GHashTableIter iter;
+    const char *name = NULL;
+    gpointer ignore_delay = NULL;
+    GList *batches = NULL;
+
+    g_hash_table_iter_init(&iter, pending_writes);
+    while (g_hash_table_iter_next(&iter, (gpointer *) &name, &ignore_delay)) {
+        attribute_t *a = g_hash_table_lookup(attributes, name);
+
+        if (a != NULL) {
+            add_attribute_to_batch(a, GPOINTER_TO_INT(ignore_delay), &batches);
+        }
+    }
+    g_hash_table_remove_all(pending_writes);
+
+    g_list_free_full(batches, send_batch);
+    return TRUE;
+}
+
+void
+write_attribute(attribute_t *a, bool ignore_delay)
+{
+    gboolean pending_ignore_delay = FALSE;
+
+    if (a == NULL) {
+        return;
+    }
+
+    if (pending_writes == NULL) {
+        pending_writes = g_hash_table_new_full(crm_str_hash, g_str_equal, free,
+                                               NULL);
+        write_trigger = mainloop_add_trigger(G_PRIORITY_DEFAULT,
+                                             write_pending_attributes, NULL);
+    }
+
+    // If the attribute is already pending, dampening is ignored if either says
+    pending_ignore_delay = GPOINTER_TO_INT(g_hash_table_lookup(pending_writes,
+                                                               a->id));
+    g_hash_table_replace(pending_writes, strdup(a->id),
+                         GINT_TO_POINTER(pending_ignore_delay || ignore_delay));
+    mainloop_set_trigger(write_trigger);
 }
@@ -13,7 +13,6 @@
 #include <stdbool.h>
 #include <errno.h>
 #include <glib.h>
-#include <regex.h>
 #include <sys/types.h>
 
 #include <crm/crm.h>
@@ -234,40 +233,154 @@ attrd_expand_value(const char *value, const char *old_value)
     return int_value;
 }
 
+/* Failure-related attribute names, indexed by resource name (each entry is a
+ * table of attribute names for the resource). The names are owned by the
+ * attributes table, which never removes entries while we are running.
+ */
+static GHashTable *failure_attrs = NULL;
+
 /*!
  * \internal
- * \brief Create regular expression matching failure-related attributes
+ * \brief Get the resource name part of a failure-related attribute name
  *
- * \param[out] regex  Where to store created regular expression
- * \param[in]  rsc    Name of resource to clear (or NULL for all)
- * \param[in]  op     Operation to clear if rsc is specified (or NULL for all)
- * \param[in]  interval_ms  Interval of operation to clear if op is specified
+ * \param[in] name  Attribute name
  *
- * \return pcmk_ok on success, -EINVAL if arguments are invalid
- *
- * \note The caller is responsible for freeing the result with regfree().
+ * \return Newly allocated resource name, or NULL if \p name is not a
+ *         failure-related attribute
  */
-int
-attrd_failure_regex(regex_t *regex, const char *rsc, const char *op,
-                    guint interval_ms)
+static char *
+failure_attr_rsc(const char *name)
 {
-    char *pattern = NULL;
-    int rc;
+    static const char *prefixes[] = {
+        PCMK__FAIL_COUNT_PREFIX "-", PCMK__LAST_FAILURE_PREFIX "-"
+    };
+
+    for (int i = 0; i < DIMOF(prefixes); i++) {
+        size_t len = strlen(prefixes[i]);
+
+        if (strncmp(name, prefixes[i], len) == 0) {
+            const char *rsc = name + len;
 
-    /* Create a pattern that matches desired attributes */
+            /* @COMPAT attributes set < 1.1.17 do not have the operation part,
+             * so the resource name may run to the end
+             */
+            size_t rsc_len = strcspn(rsc, "#");
+
+            return (rsc_len == 0)? NULL : strndup(rsc, rsc_len);
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * \internal
+ * \brief Add an attribute to the failure attribute index if appropriate
+ *
+ * \param[in] name  Name of newly created attribute
+ */
+void
+attrd_index_failure_attr(const char *name)
+{
+    char *rsc = failure_attr_rsc(name);
+    GHashTable *names = NULL;
 
     if (rsc == NULL) {
-        pattern = strdup(ATTRD_RE_CLEAR_ALL);
-    } else if (op == NULL) {
-        pattern = crm_strdup_printf(ATTRD_RE_CLEAR_ONE, rsc);
+        return;
+    }
+
+    if (failure_attrs == NULL) {
+        failure_attrs = g_hash_table_new_full(crm_str_hash, g_str_equal, free,
+                                              (GDestroyNotify) g_hash_table_destroy);
+    }
+
+    names = g_hash_table_lookup(failure_attrs, rsc);
+    if (names == NULL) {
+        names = g_hash_table_new(crm_str_hash, g_str_equal);
+        g_hash_table_insert(failure_attrs, rsc, names);
     } else {
-        pattern = crm_strdup_printf(ATTRD_RE_CLEAR_OP, rsc, op, interval_ms);
+        free(rsc);
+    }
+    g_hash_table_add(names, (gpointer) name);
+}
+
+static GList *
+add_indexed_name(GList *list, GHashTable *names, const char *name)
+{
+    gpointer indexed = NULL;
+
+    if (g_hash_table_lookup_extended(names, name, &indexed, NULL)) {
+        list = g_list_prepend(list, indexed);
     }
+    return list;
+}
+
+/*!
+ * \internal
+ * \brief List failure-related attributes matching a clear request
+ *
+ * \param[in] rsc          Name of resource to clear (or NULL for all)
+ * \param[in] op           Operation to clear if rsc is specified (or NULL for all)
+ * \param[in] interval_ms  Interval of operation to clear if op is specified
+ *
+ * \return List of matching attribute names
+ *
+ * \note The caller is responsible for freeing the result with g_list_free(),
+ *       but not the names in it.
+ */
+GList *
+attrd_failure_attrs(const char *rsc, const char *op, guint interval_ms)
+{
+    GList *list = NULL;
+    GHashTable *names = NULL;
+    char *name = NULL;
+
+    if (failure_attrs == NULL) {
+        return NULL;
+    }
+
+    if (rsc == NULL) {
+        GHashTableIter iter;
 
-    /* Compile pattern into regular expression */
-    crm_trace("Clearing attributes matching %s", pattern);
-    rc = regcomp(regex, pattern, REG_EXTENDED|REG_NOSUB);
-    free(pattern);
+        g_hash_table_iter_init(&iter, failure_attrs);
+        while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &names)) {
+            list = g_list_concat(list, g_hash_table_get_keys(names));
+        }
+        return list;
+    }
+
+    names = g_hash_table_lookup(failure_attrs, rsc);
+    if (names == NULL) {
+        return NULL;
+    }
+    if (op == NULL) {
+        return g_hash_table_get_keys(names);
+    }
+
+    name = pcmk__failcount_name(rsc, op, interval_ms);
+    list = add_indexed_name(list, names, name);
+    free(name);
+
+    name = pcmk__lastfailure_name(rsc, op, interval_ms);
+    list = add_indexed_name(list, names, name);
+    free(name);
+
+    // @COMPAT attributes set < 1.1.17 do not have the operation part
+    name = crm_strdup_printf(PCMK__FAIL_COUNT_PREFIX "-%s", rsc);
+    list = add_indexed_name(list, names, name);
+    free(name);
 
-    return (rc == 0)? pcmk_ok : -EINVAL;
+    name = crm_strdup_printf(PCMK__LAST_FAILURE_PREFIX "-%s", rsc);
+    list = add_indexed_name(list, names, name);
+    free(name);
+
+    return list;
+}
+
+void
+attrd_free_failure_index(void)
+{
+    if (failure_attrs != NULL) {
+        g_hash_table_destroy(failure_attrs);
+        failure_attrs = NULL;
+    }
 }
@@ -288,6 +288,10 @@ attrd_ipc_dispatch(qb_ipcs_connection_t * c, void *data, size_t size)
         attrd_send_ack(client, id, flags);
         attrd_client_update(xml);
 
+    } else if (safe_str_eq(op, PCMK__ATTRD_CMD_UPDATE_BULK)) {
+        attrd_send_ack(client, id, flags);
+        attrd_client_update_bulk(xml);
+
     } else if (safe_str_eq(op, PCMK__ATTRD_CMD_REFRESH)) {
         attrd_send_ack(client, id, flags);
         attrd_client_refresh();
@@ -443,6 +447,8 @@ main(int argc, char **argv)
     attrd_ipc_fini();
     attrd_lrmd_disconnect();
     attrd_cib_disconnect();
+    attrd_free_pattern_cache();
+    attrd_free_failure_index();
     g_hash_table_destroy(attributes);
 
     crm_exit(attrd_exit_status);
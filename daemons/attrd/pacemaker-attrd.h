@@ -10,7 +10,6 @@
 #ifndef PACEMAKER_ATTRD__H
 #  define PACEMAKER_ATTRD__H
 
-#include <regex.h>
 #include <glib.h>
 #include <crm/crm.h>
 #include <crm/cluster.h>
@@ -31,28 +30,10 @@ void attrd_cib_disconnect(void);
 gboolean attrd_value_needs_expansion(const char *value);
 int attrd_expand_value(const char *value, const char *old_value);
 
-/* regular expression to clear failures of all resources */
-#define ATTRD_RE_CLEAR_ALL \
-    "^(" PCMK__FAIL_COUNT_PREFIX "|" PCMK__LAST_FAILURE_PREFIX ")-"
-
-/* regular expression to clear failure of all operations for one resource
- * (format takes resource name)
- *
- * @COMPAT attributes set < 1.1.17:
- * also match older attributes that do not have the operation part
- */
-#define ATTRD_RE_CLEAR_ONE ATTRD_RE_CLEAR_ALL "%s(#.+_[0-9]+)?$"
-
-/* regular expression to clear failure of one operation for one resource
- * (format takes resource name, operation name, and interval)
- *
- * @COMPAT attributes set < 1.1.17:
- * also match older attributes that do not have the operation part
- */
-#define ATTRD_RE_CLEAR_OP ATTRD_RE_CLEAR_ALL "%s(#%s_%u)?$"
-
-int attrd_failure_regex(regex_t *regex, const char *rsc, const char *op,
-                        guint interval_ms);
+void attrd_index_failure_attr(const char *name);
+GList *attrd_failure_attrs(const char *rsc, const char *op, guint interval_ms);
+void attrd_free_failure_index(void);
+void attrd_free_pattern_cache(void);
 
 extern cib_t *the_cib;
 
@@ -96,6 +77,7 @@ typedef struct attribute_s {
     char *user;
 
     gboolean force_write; /* Flag for updating attribute by ignoring delay */
+    bool write_alone; /* whether to write separately after a combined write failed */
 
 } attribute_t;
 
@@ -106,6 +88,7 @@ typedef struct attribute_value_s {
         char *current;
         char *requested;
         gboolean seen;
+        unsigned int version;   // bumped on every change, adopted on sync
 } attribute_value_t;
 
 extern crm_cluster_t *attrd_cluster;
@@ -122,6 +105,7 @@ void attrd_peer_message(crm_node_t *client, xmlNode *msg);
 void attrd_client_peer_remove(const char *client_name, xmlNode *xml);
 void attrd_client_clear_failure(xmlNode *xml);
 void attrd_client_update(xmlNode *xml);
+void attrd_client_update_bulk(xmlNode *xml);
 void attrd_client_refresh(void);
 void attrd_client_query(pcmk__client_t *client, uint32_t id, uint32_t flags,
                         xmlNode *query);
@@ -32,8 +32,7 @@ int pending_updates = 0;
 
 struct cib_notification_s {
     xmlNode *msg;
-    struct iovec *iov;
-    int32_t iov_size;
+    pcmk__ipc_shared_event_t *event; // Serialized once for all IPC clients
 };
 
 void attach_cib_generation(xmlNode * msg, const char *field, xmlNode * a_cib);
@@ -82,8 +81,8 @@ cib_notify_send_one(gpointer key, gpointer value, gpointer user_data)
     if (do_send) {
         switch (client->kind) {
             case PCMK__CLIENT_IPC:
-                if (pcmk__ipc_send_iov(client, update->iov,
-                                       crm_ipc_server_event) != pcmk_rc_ok) {
+                if (pcmk__ipc_send_shared_event(client, update->event,
+                                                crm_ipc_server_event) != pcmk_rc_ok) {
                     crm_warn("Notification of client %s/%s failed", client->name, client->id);
                 }
                 break;
@@ -104,24 +103,19 @@ cib_notify_send_one(gpointer key, gpointer value, gpointer user_data)
 static void
 cib_notify_send(xmlNode * xml)
 {
-    struct iovec *iov;
     struct cib_notification_s update;
-
-    ssize_t bytes = 0;
-    int rc = pcmk__ipc_prepare_iov(0, xml, 0, &iov, &bytes);
+    int rc = pcmk__ipc_new_shared_event(xml, &(update.event));
 
     crm_trace("Notifying clients");
     if (rc == pcmk_rc_ok) {
         update.msg = xml;
-        update.iov = iov;
-        update.iov_size = bytes;
         pcmk__foreach_ipc_client_remove(cib_notify_send_one, &update);
+        pcmk__ipc_free_shared_event(update.event);
 
     } else {
         crm_notice("Could not notify clients: %s " CRM_XS " rc=%d",
                    pcmk_rc_str(rc), rc);
     }
-    pcmk_free_ipc_event(iov);
     crm_trace("Notify complete");
 }
 
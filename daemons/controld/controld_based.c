@@ -26,12 +26,14 @@ do_cib_updated(const char *event, xmlNode * msg)
     if (pcmk__alert_in_patchset(msg, TRUE)) {
         mainloop_set_trigger(config_read);
     }
+    controld_sched_cib_updated(msg);
 }
 
 static void
 do_cib_replaced(const char *event, xmlNode * msg)
 {
     crm_debug("Updating the CIB after a replace: DC=%s", AM_I_DC ? "true" : "false");
+    controld_sched_cib_replaced();
     if (AM_I_DC == FALSE) {
         return;
 
@@ -56,6 +58,7 @@ do_cib_control(long long action,
 
     if (action & A_CIB_STOP) {
 
+        controld_flush_resource_updates();
         if (fsa_cib_conn->state != cib_disconnected && last_resource_update != 0) {
             crm_info("Waiting for resource update %d to complete", last_resource_update);
             crmd_fsa_stall(FALSE);
@@ -206,6 +209,29 @@ cib_delete_callback(xmlNode *msg, int call_id, int rc, xmlNode *output,
 // Unlocked history + transient attributes (name 3x)
 #define XPATH_NODE_ALL_UNLOCKED XPATH_NODE_LRM_UNLOCKED "|" XPATH_NODE_ATTRS
 
+// Node's lrm_resource entries (name 1x)
+#define XPATH_NODE_RESOURCES    XPATH_NODE_LRM "/" XML_LRM_TAG_RESOURCES    \
+                                "/" XML_LRM_TAG_RESOURCE
+
+static void
+delete_by_xpath(const char *xpath, char *desc, int options)
+{
+    if (fsa_cib_conn == NULL) {
+        crm_warn("Unable to delete %s: no CIB connection", desc);
+        free(desc);
+    } else {
+        int call_id;
+
+        controld_flush_resource_updates();
+        options |= cib_quorum_override|cib_xpath|cib_multiple;
+        call_id = fsa_cib_conn->cmds->remove(fsa_cib_conn, xpath, NULL, options);
+        crm_info("Deleting %s (via CIB call %d) " CRM_XS " xpath=%s",
+                 desc, call_id, xpath);
+        fsa_register_cib_callback(call_id, FALSE, desc, cib_delete_callback);
+        // CIB library handles freeing desc
+    }
+}
+
 /*!
  * \internal
  * \brief Delete subsection of a node's CIB node_state
@@ -247,21 +273,49 @@ controld_delete_node_state(const char *uname, enum controld_section_e section,
                                      "for node %s", uname);
             break;
     }
+    delete_by_xpath(xpath, desc, options);
+    free(xpath);
+}
 
-    if (fsa_cib_conn == NULL) {
-        crm_warn("Unable to delete %s: no CIB connection", desc);
-        free(desc);
-    } else {
-        int call_id;
+/*!
+ * \internal
+ * \brief Delete a node's resource history, except for certain resources
+ *
+ * \param[in] uname    Desired node
+ * \param[in] keep     XML whose lrm_resource children identify the resources
+ *                     whose history should be kept
+ * \param[in] options  CIB call options to use
+ */
+void
+controld_delete_node_history_except(const char *uname, xmlNode *keep,
+                                    int options)
+{
+    GString *xpath = NULL;
+    const char *separator = "[";
+    int kept = 0;
 
-        options |= cib_quorum_override|cib_xpath|cib_multiple;
-        call_id = fsa_cib_conn->cmds->remove(fsa_cib_conn, xpath, NULL, options);
-        crm_info("Deleting %s (via CIB call %d) " CRM_XS " xpath=%s",
-                 desc, call_id, xpath);
-        fsa_register_cib_callback(call_id, FALSE, desc, cib_delete_callback);
-        // CIB library handles freeing desc
+    CRM_CHECK(uname != NULL, return);
+    xpath = g_string_new(NULL);
+    g_string_printf(xpath, XPATH_NODE_RESOURCES, uname);
+    for (xmlNode *rsc = first_named_child(keep, XML_LRM_TAG_RESOURCE);
+         rsc != NULL; rsc = crm_next_same_xml(rsc)) {
+
+        if (ID(rsc) != NULL) {
+            g_string_append_printf(xpath, "%s@" XML_ATTR_ID "!='%s'",
+                                   separator, ID(rsc));
+            separator = " and ";
+            kept++;
+        }
     }
-    free(xpath);
+    if (kept > 0) {
+        g_string_append_c(xpath, ']');
+    }
+    delete_by_xpath(xpath->str,
+                    crm_strdup_printf("resource history for node %s (other "
+                                      "than %d unchanged resource%s)",
+                                      uname, kept, pcmk__plural_s(kept)),
+                    options);
+    g_string_free(xpath, TRUE);
 }
 
 // Takes node name and resource ID
@@ -300,7 +354,8 @@ controld_delete_resource_history(const char *rsc_id, const char *node,
         return ENOTCONN;
     }
 
-    // Ask CIB to delete the entry
+    // Ask CIB to delete the entry (after any queued updates for it)
+    controld_flush_resource_updates();
     xpath = crm_strdup_printf(XPATH_RESOURCE_HISTORY, node, rsc_id);
     rc = cib_internal_op(fsa_cib_conn, CIB_OP_DELETE, NULL, xpath, NULL,
                          NULL, call_options|cib_xpath, user_name);
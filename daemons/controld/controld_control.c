@@ -217,6 +217,7 @@ crmd_exit(crm_exit_t exit_code)
 
     clear_bit(fsa_input_register, R_MEMBERSHIP);
     g_list_free(fsa_message_queue); fsa_message_queue = NULL;
+    fsa_message_queue_len = 0;
 
     metadata_cache_fini();
     controld_election_fini();
@@ -298,6 +299,7 @@ crmd_exit(crm_exit_t exit_code)
     fsa_cib_conn = NULL;
 
     throttle_fini();
+    controld_metrics_fini();
 
     /* Graceful */
     crm_trace("Done preparing for exit with status %d (%s)",
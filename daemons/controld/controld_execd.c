@@ -44,8 +44,8 @@ static void do_lrm_rsc_op(lrm_state_t *lrm_state, lrmd_rsc_info_t *rsc,
 
 static gboolean lrm_state_verify_stopped(lrm_state_t * lrm_state, enum crmd_fsa_state cur_state,
                                          int log_level);
-static int do_update_resource(const char *node_name, lrmd_rsc_info_t *rsc,
-                              lrmd_event_data_t *op, time_t lock_time);
+static bool do_update_resource(const char *node_name, lrmd_rsc_info_t *rsc,
+                               lrmd_event_data_t *op, time_t lock_time);
 
 static void
 lrm_connection_destroy(void)
@@ -83,6 +83,19 @@ copy_meta_keys(gpointer key, gpointer value, gpointer user_data)
     }
 }
 
+/*!
+ * \internal
+ * \brief Mark a resource's cached history XML as out of date
+ *
+ * \param[in,out] history  Resource history that changed
+ */
+static void
+history_changed(rsc_history_t *history)
+{
+    free_xml(history->xml);
+    history->xml = NULL;
+}
+
 /*!
  * \internal
  * \brief Remove a recurring operation from a resource's history
@@ -95,21 +108,62 @@ copy_meta_keys(gpointer key, gpointer value, gpointer user_data)
 static gboolean
 history_remove_recurring_op(rsc_history_t *history, const lrmd_event_data_t *op)
 {
-    GList *iter;
+    char *key = NULL;
+    gboolean removed = FALSE;
 
-    for (iter = history->recurring_op_list; iter != NULL; iter = iter->next) {
-        lrmd_event_data_t *existing = iter->data;
+    if (history->recurring_ops == NULL) {
+        return FALSE;
+    }
+    key = pcmk__op_key(op->rsc_id, op->op_type, op->interval_ms);
+    removed = g_hash_table_remove(history->recurring_ops, key);
+    free(key);
+    return removed;
+}
 
-        if ((op->interval_ms == existing->interval_ms)
-            && crm_str_eq(op->rsc_id, existing->rsc_id, TRUE)
-            && safe_str_eq(op->op_type, existing->op_type)) {
+/*!
+ * \internal
+ * \brief Add a recurring operation to a resource's history
+ *
+ * \param[in,out] history  Resource history to modify
+ * \param[in]     op       Operation to add (replacing any with the same key)
+ */
+static void
+history_add_recurring_op(rsc_history_t *history, lrmd_event_data_t *op)
+{
+    if (history->recurring_ops == NULL) {
+        history->recurring_ops = g_hash_table_new_full(crm_str_hash,
+                                                       g_str_equal, free,
+                                                       (GDestroyNotify) lrmd_free_event);
+    }
+    g_hash_table_replace(history->recurring_ops,
+                         pcmk__op_key(op->rsc_id, op->op_type, op->interval_ms),
+                         lrmd_copy_event(op));
+}
 
-            history->recurring_op_list = g_list_delete_link(history->recurring_op_list, iter);
-            lrmd_free_event(existing);
-            return TRUE;
-        }
+/*!
+ * \internal
+ * \brief Find a recurring operation in a resource's history
+ *
+ * \param[in] lrm_state  Executor state that resource history is for
+ * \param[in] op         Operation to find
+ *
+ * \return Last recorded result of \p op if known, otherwise NULL
+ */
+static lrmd_event_data_t *
+history_find_recurring_op(lrm_state_t *lrm_state, const lrmd_event_data_t *op)
+{
+    rsc_history_t *history = g_hash_table_lookup(lrm_state->resource_history,
+                                                 op->rsc_id);
+    lrmd_event_data_t *last = NULL;
+    char *key = NULL;
+
+    if ((history == NULL) || (history->recurring_ops == NULL)) {
+        return NULL;
     }
-    return FALSE;
+    key = pcmk__op_key(op->rsc_id, op->op_type, op->interval_ms);
+    last = g_hash_table_lookup(history->recurring_ops, key);
+    free(key);
+    return last;
 }
 
 /*!
@@ -121,13 +175,10 @@ history_remove_recurring_op(rsc_history_t *history, const lrmd_event_data_t *op)
 static void
 history_free_recurring_ops(rsc_history_t *history)
 {
-    GList *iter;
-
-    for (iter = history->recurring_op_list; iter != NULL; iter = iter->next) {
-        lrmd_free_event(iter->data);
+    if (history->recurring_ops != NULL) {
+        g_hash_table_destroy(history->recurring_ops);
+        history->recurring_ops = NULL;
     }
-    g_list_free(history->recurring_op_list);
-    history->recurring_op_list = NULL;
 }
 
 /*!
@@ -154,6 +205,7 @@ history_free(gpointer data)
     lrmd_free_event(history->last);
     free(history->id);
     history_free_recurring_ops(history);
+    free_xml(history->xml);
     free(history);
 }
 
@@ -196,6 +248,7 @@ update_history_cache(lrm_state_t * lrm_state, lrmd_rsc_info_t * rsc, lrmd_event_
         return;
     }
 
+    history_changed(entry);
     entry->last_callid = op->call_id;
     target_rc = rsc_op_expected_rc(op);
     if (op->op_status == PCMK_LRM_OP_CANCELLED) {
@@ -240,16 +293,13 @@ update_history_cache(lrm_state_t * lrm_state, lrmd_rsc_info_t * rsc, lrmd_event_
     }
 
     if (op->interval_ms > 0) {
-        /* Ensure there are no duplicates */
-        history_remove_recurring_op(entry, op);
-
         crm_trace("Adding recurring op: " PCMK__OP_FMT,
                   op->rsc_id, op->op_type, op->interval_ms);
-        entry->recurring_op_list = g_list_prepend(entry->recurring_op_list, lrmd_copy_event(op));
+        history_add_recurring_op(entry, op);
 
-    } else if (entry->recurring_op_list && safe_str_eq(op->op_type, RSC_STATUS) == FALSE) {
+    } else if (entry->recurring_ops && safe_str_eq(op->op_type, RSC_STATUS) == FALSE) {
         crm_trace("Dropping %d recurring ops because of: " PCMK__OP_FMT,
-                  g_list_length(entry->recurring_op_list), op->rsc_id,
+                  g_hash_table_size(entry->recurring_ops), op->rsc_id,
                   op->op_type, op->interval_ms);
         history_free_recurring_ops(entry);
     }
@@ -663,8 +713,10 @@ build_operation_update(xmlNode * parent, lrmd_rsc_info_t * rsc, lrmd_event_data_
      * however with our upgrade policy, the update we send should
      * still be completely supported anyway
      */
-    caller_version = g_hash_table_lookup(op->params, XML_ATTR_CRM_VERSION);
-    CRM_LOG_ASSERT(caller_version != NULL);
+    if (op->params != NULL) { // Unknown only if result is logged as such
+        caller_version = g_hash_table_lookup(op->params, XML_ATTR_CRM_VERSION);
+        CRM_LOG_ASSERT(caller_version != NULL);
+    }
 
     if(caller_version == NULL) {
         caller_version = CRM_FEATURE_SET;
@@ -772,6 +824,50 @@ is_rsc_active(lrm_state_t * lrm_state, const char *rsc_id)
     return TRUE;
 }
 
+/*!
+ * \internal
+ * \brief Build the resource history XML for one resource
+ *
+ * \param[in] lrm_state  Executor state that resource history is for
+ * \param[in] entry      Resource history to build XML for
+ * \param[in] origin     Function to record as origin of the history
+ *
+ * \return Newly allocated lrm_resource XML
+ */
+static xmlNode *
+build_rsc_history_xml(lrm_state_t *lrm_state, rsc_history_t *entry,
+                      const char *origin)
+{
+    GHashTableIter iter;
+    lrmd_event_data_t *op = NULL;
+    xmlNode *xml_rsc = create_xml_node(NULL, XML_LRM_TAG_RESOURCE);
+
+    crm_xml_add(xml_rsc, XML_ATTR_ID, entry->id);
+    crm_xml_add(xml_rsc, XML_ATTR_TYPE, entry->rsc.type);
+    crm_xml_add(xml_rsc, XML_AGENT_ATTR_CLASS, entry->rsc.standard);
+    crm_xml_add(xml_rsc, XML_AGENT_ATTR_PROVIDER, entry->rsc.provider);
+
+    if (entry->last && entry->last->params) {
+        const char *container = g_hash_table_lookup(entry->last->params, CRM_META"_"XML_RSC_ATTR_CONTAINER);
+        if (container) {
+            crm_trace("Resource %s is a part of container resource %s", entry->id, container);
+            crm_xml_add(xml_rsc, XML_RSC_ATTR_CONTAINER, container);
+        }
+    }
+    build_operation_update(xml_rsc, &(entry->rsc), entry->failed,
+                           lrm_state->node_name, origin);
+    build_operation_update(xml_rsc, &(entry->rsc), entry->last,
+                           lrm_state->node_name, origin);
+    if (entry->recurring_ops) {
+        g_hash_table_iter_init(&iter, entry->recurring_ops);
+        while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &op)) {
+            build_operation_update(xml_rsc, &(entry->rsc), op,
+                                   lrm_state->node_name, origin);
+        }
+    }
+    return xml_rsc;
+}
+
 static gboolean
 build_active_RAs(lrm_state_t * lrm_state, xmlNode * rsc_list)
 {
@@ -781,26 +877,26 @@ build_active_RAs(lrm_state_t * lrm_state, xmlNode * rsc_list)
     g_hash_table_iter_init(&iter, lrm_state->resource_history);
     while (g_hash_table_iter_next(&iter, NULL, (void **)&entry)) {
 
-        GList *gIter = NULL;
-        xmlNode *xml_rsc = create_xml_node(rsc_list, XML_LRM_TAG_RESOURCE);
-
-        crm_xml_add(xml_rsc, XML_ATTR_ID, entry->id);
-        crm_xml_add(xml_rsc, XML_ATTR_TYPE, entry->rsc.type);
-        crm_xml_add(xml_rsc, XML_AGENT_ATTR_CLASS, entry->rsc.standard);
-        crm_xml_add(xml_rsc, XML_AGENT_ATTR_PROVIDER, entry->rsc.provider);
+        if (entry->xml == NULL) {
+            /* The DC's update_failcount() recognizes old failures from a
+             * status refresh by this function's name as their origin.
+             */
+            xmlNode *xml_rsc = build_rsc_history_xml(lrm_state, entry,
+                                                     __FUNCTION__);
 
-        if (entry->last && entry->last->params) {
-            const char *container = g_hash_table_lookup(entry->last->params, CRM_META"_"XML_RSC_ATTR_CONTAINER);
-            if (container) {
-                crm_trace("Resource %s is a part of container resource %s", entry->id, container);
-                crm_xml_add(xml_rsc, XML_RSC_ATTR_CONTAINER, container);
+            /* Without agent meta-data, the operation digests can't be
+             * calculated yet, so don't keep the result around.
+             */
+            if (crm_op_needs_metadata(entry->rsc.standard, NULL)
+                && (metadata_cache_get(lrm_state->metadata_cache,
+                                       &(entry->rsc)) == NULL)) {
+                add_node_copy(rsc_list, xml_rsc);
+                free_xml(xml_rsc);
+                continue;
             }
+            entry->xml = xml_rsc;
         }
-        build_operation_update(xml_rsc, &(entry->rsc), entry->failed, lrm_state->node_name, __FUNCTION__);
-        build_operation_update(xml_rsc, &(entry->rsc), entry->last, lrm_state->node_name, __FUNCTION__);
-        for (gIter = entry->recurring_op_list; gIter != NULL; gIter = gIter->next) {
-            build_operation_update(xml_rsc, &(entry->rsc), gIter->data, lrm_state->node_name, __FUNCTION__);
-        }
+        add_node_copy(rsc_list, entry->xml);
     }
 
     return FALSE;
@@ -1004,6 +1100,8 @@ erase_lrm_history_by_op(lrm_state_t *lrm_state, lrmd_event_data_t *op)
     crm_debug("Erasing resource operation history for " PCMK__OP_FMT " (call=%d)",
               op->rsc_id, op->op_type, op->interval_ms, op->call_id);
 
+    controld_flush_resource_updates();
+
     fsa_cib_conn->cmds->remove(fsa_cib_conn, XML_CIB_TAG_STATUS, xml_top,
                                cib_quorum_override);
 
@@ -1065,6 +1163,7 @@ erase_lrm_history_by_id(lrm_state_t *lrm_state, const char *rsc_id,
 
     crm_debug("Erasing resource operation history for %s on %s (call=%d)",
               key, rsc_id, call_id);
+    controld_flush_resource_updates();
     fsa_cib_conn->cmds->remove(fsa_cib_conn, op_xpath, NULL,
                                cib_quorum_override | cib_xpath);
     free(op_xpath);
@@ -1126,6 +1225,7 @@ lrm_clear_last_failure(const char *rsc_id, const char *node_name,
         if (last_failed_matches_op(entry, operation, interval_ms)) {
             lrmd_free_event(entry->failed);
             entry->failed = NULL;
+            history_changed(entry);
         }
     }
 }
@@ -1552,6 +1652,7 @@ handle_refresh_op(lrm_state_t *lrm_state, const char *user_name,
     int rc = pcmk_ok;
     xmlNode *fragment = do_lrm_query_internal(lrm_state, node_update_all);
 
+    controld_flush_resource_updates();
     fsa_cib_update(XML_CIB_TAG_STATUS, fragment, cib_quorum_override, rc, user_name);
     crm_info("Forced a local resource history refresh: call=%d", rc);
 
@@ -2351,6 +2452,27 @@ do_lrm_rsc_op(lrm_state_t *lrm_state, lrmd_rsc_info_t *rsc,
 
 int last_resource_update = 0;
 
+/* Operation results (and pending operations) are not written to the CIB one at
+ * a time, but collected into a single status update that is sent when this
+ * many milliseconds have passed since the first was queued, or when this many
+ * have been queued, whichever comes first. This turns a burst of results (for
+ * example, when many resources are started at once) into a few CIB updates.
+ */
+#define RESOURCE_UPDATE_DELAY_MS    100
+#define RESOURCE_UPDATE_MAX_OPS     100
+
+static xmlNode *resource_updates = NULL;    // Queued status update
+static int resource_update_ops = 0;         // Operations in queued update
+static guint resource_update_timer = 0;     // Timer to send queued update
+
+// Result log message waiting for the CIB call ID of the update recording it
+struct result_log_s {
+    int level;
+    char *text;
+};
+
+static GList *resource_update_logs = NULL;  // Logs for queued update
+
 static void
 cib_rsc_callback(xmlNode * msg, int call_id, int rc, xmlNode * output, void *user_data)
 {
@@ -2370,6 +2492,132 @@ cib_rsc_callback(xmlNode * msg, int call_id, int rc, xmlNode * output, void *use
     }
 }
 
+/*!
+ * \internal
+ * \brief Send any queued resource history updates to the CIB
+ *
+ * \note This must be called before any other CIB request that could affect
+ *       resource history, so that the CIB sees changes in the right order.
+ */
+void
+controld_flush_resource_updates(void)
+{
+    int rc = pcmk_ok;
+    int call_opt = crmd_cib_smart_opt();
+
+    if (resource_update_timer != 0) {
+        g_source_remove(resource_update_timer);
+        resource_update_timer = 0;
+    }
+    if (resource_updates == NULL) {
+        return;
+    }
+
+    crm_log_xml_trace(resource_updates, __FUNCTION__);
+
+    /* make it an asynchronous call and be done with it
+     *
+     * Best case:
+     *   the resource state will be discovered during
+     *   the next signup or election.
+     *
+     * Bad case:
+     *   we are shutting down and there is no DC at the time,
+     *   but then why were we shutting down then anyway?
+     *   (probably because of an internal error)
+     *
+     * Worst case:
+     *   we get shot for having resources "running" that really weren't
+     *
+     * the alternative however means blocking here for too long, which
+     * isn't acceptable
+     */
+    fsa_cib_update(XML_CIB_TAG_STATUS, resource_updates, call_opt, rc, NULL);
+
+    if (rc > 0) {
+        last_resource_update = rc;
+    }
+
+    /* the return code is a call number, not an error code */
+    crm_debug("Sent resource state update message %d for %d operation%s",
+              rc, resource_update_ops, pcmk__plural_s(resource_update_ops));
+    fsa_register_cib_callback(rc, FALSE, NULL, cib_rsc_callback);
+
+    for (GList *iter = resource_update_logs; iter != NULL; iter = iter->next) {
+        struct result_log_s *result_log = iter->data;
+
+        do_crm_log(result_log->level, "%s cib-update=%d", result_log->text, rc);
+        free(result_log->text);
+        free(result_log);
+    }
+    g_list_free(resource_update_logs);
+    resource_update_logs = NULL;
+
+    free_xml(resource_updates);
+    resource_updates = NULL;
+    resource_update_ops = 0;
+}
+
+/*!
+ * \internal
+ * \brief Log an operation result along with the CIB call ID that records it
+ *
+ * \param[in] level   Log level to use
+ * \param[in] queued  Whether the result is in the queued status update
+ * \param[in] text    Log message without call ID (this takes ownership)
+ *
+ * \note If \p queued is true, the message is logged when the queued update is
+ *       sent, because the call ID isn't known until then.
+ */
+static void
+log_recorded_result(int level, bool queued, char *text)
+{
+    if (queued && (resource_updates != NULL)) {
+        struct result_log_s *result_log = calloc(1, sizeof(struct result_log_s));
+
+        CRM_ASSERT(result_log != NULL);
+        result_log->level = level;
+        result_log->text = text;
+        resource_update_logs = g_list_append(resource_update_logs, result_log);
+        return;
+    }
+    do_crm_log(level, "%s cib-update=0", text);
+    free(text);
+}
+
+static gboolean
+resource_update_timer_cb(gpointer user_data)
+{
+    resource_update_timer = 0;
+    controld_flush_resource_updates();
+    return FALSE;
+}
+
+/*!
+ * \internal
+ * \brief Find or create an entry in the queued status update
+ *
+ * \param[in] parent  Parent element in queued update
+ * \param[in] name    Element name of entry
+ * \param[in] id      ID of entry
+ *
+ * \return Existing or newly created entry
+ */
+static xmlNode *
+queued_update_entry(xmlNode *parent, const char *name, const char *id)
+{
+    xmlNode *entry = NULL;
+
+    // IDs (including node names) are case-sensitive
+    entry = find_entity(parent, name, id);
+    if (entry != NULL) {
+        return entry;
+    }
+    entry = create_xml_node(parent, name);
+    crm_xml_add(entry, XML_ATTR_ID, id);
+    return entry;
+}
+
 /* Only successful stops, and probes that found the resource inactive, get locks
  * recorded in the history. This ensures the resource stays locked to the node
  * until it is active there again after the node comes back up.
@@ -2389,7 +2637,7 @@ should_preserve_lock(lrmd_event_data_t *op)
     return false;
 }
 
-static int
+static bool
 do_update_resource(const char *node_name, lrmd_rsc_info_t *rsc,
                    lrmd_event_data_t *op, time_t lock_time)
 {
@@ -2401,16 +2649,19 @@ do_update_resource(const char *node_name, lrmd_rsc_info_t *rsc,
   <lrm_resource id=...>
   </...>
 */
-    int rc = pcmk_ok;
-    xmlNode *update, *iter = NULL;
-    int call_opt = crmd_cib_smart_opt();
+    xmlNode *iter = NULL;
+    xmlNode *history = NULL;
+    xmlNode *entry = NULL;
     const char *uuid = NULL;
+    const char *container = NULL;
 
-    CRM_CHECK(op != NULL, return 0);
+    CRM_CHECK(op != NULL, return FALSE);
 
-    iter = create_xml_node(iter, XML_CIB_TAG_STATUS);
-    update = iter;
-    iter = create_xml_node(iter, XML_CIB_TAG_STATE);
+    if (rsc == NULL) {
+        crm_warn("Resource %s no longer exists in the executor", op->rsc_id);
+        controld_ack_event_directly(NULL, NULL, rsc, op, op->rsc_id);
+        return FALSE;
+    }
 
     if (safe_str_eq(node_name, fsa_our_uname)) {
         uuid = fsa_our_uuid;
@@ -2418,92 +2669,86 @@ do_update_resource(const char *node_name, lrmd_rsc_info_t *rsc,
     } else {
         /* remote nodes uuid and uname are equal */
         uuid = node_name;
-        crm_xml_add(iter, XML_NODE_IS_REMOTE, "true");
     }
 
     CRM_LOG_ASSERT(uuid != NULL);
     if(uuid == NULL) {
-        rc = -EINVAL;
-        goto done;
+        return FALSE;
     }
 
-    crm_xml_add(iter, XML_ATTR_UUID,  uuid);
+    if (resource_updates == NULL) {
+        resource_updates = create_xml_node(NULL, XML_CIB_TAG_STATUS);
+    }
+
+    iter = queued_update_entry(resource_updates, XML_CIB_TAG_STATE, uuid);
+    if (safe_str_neq(node_name, fsa_our_uname)) {
+        crm_xml_add(iter, XML_NODE_IS_REMOTE, "true");
+    }
     crm_xml_add(iter, XML_ATTR_UNAME, node_name);
     crm_xml_add(iter, XML_ATTR_ORIGIN, __FUNCTION__);
 
-    iter = create_xml_node(iter, XML_CIB_TAG_LRM);
-    crm_xml_add(iter, XML_ATTR_ID, uuid);
+    iter = queued_update_entry(iter, XML_CIB_TAG_LRM, uuid);
+    iter = queued_update_entry(iter, XML_LRM_TAG_RESOURCES, NULL);
+    iter = queued_update_entry(iter, XML_LRM_TAG_RESOURCE, op->rsc_id);
 
-    iter = create_xml_node(iter, XML_LRM_TAG_RESOURCES);
-    iter = create_xml_node(iter, XML_LRM_TAG_RESOURCE);
-    crm_xml_add(iter, XML_ATTR_ID, op->rsc_id);
-
-    build_operation_update(iter, rsc, op, node_name, __FUNCTION__);
+    /* Build the history entries separately, so that any queued entries with
+     * the same IDs (from an earlier result of the same operation) can be
+     * replaced rather than duplicated
+     */
+    history = create_xml_node(NULL, XML_LRM_TAG_RESOURCE);
+    build_operation_update(history, rsc, op, node_name, __FUNCTION__);
+    for (entry = __xml_first_child(history); entry != NULL;
+         entry = __xml_next(entry)) {
 
-    if (rsc) {
-        const char *container = NULL;
+        xmlNode *queued = find_entity(iter, crm_element_name(entry), ID(entry));
 
-        crm_xml_add(iter, XML_ATTR_TYPE, rsc->type);
-        crm_xml_add(iter, XML_AGENT_ATTR_CLASS, rsc->standard);
-        crm_xml_add(iter, XML_AGENT_ATTR_PROVIDER, rsc->provider);
-        if (lock_time != 0) {
-            /* Actions on a locked resource should either preserve the lock by
-             * recording it with the action result, or clear it.
-             */
-            if (!should_preserve_lock(op)) {
-                lock_time = 0;
-            }
-            crm_xml_add_ll(iter, XML_CONFIG_ATTR_SHUTDOWN_LOCK,
-                           (long long) lock_time);
+        if (queued != NULL) {
+            free_xml(queued);
         }
+        add_node_copy(iter, entry);
+    }
+    free_xml(history);
 
-        if (op->params) {
-            container = g_hash_table_lookup(op->params, CRM_META"_"XML_RSC_ATTR_CONTAINER);
-        }
-        if (container) {
-            crm_trace("Resource %s is a part of container resource %s", op->rsc_id, container);
-            crm_xml_add(iter, XML_RSC_ATTR_CONTAINER, container);
+    crm_xml_add(iter, XML_ATTR_TYPE, rsc->type);
+    crm_xml_add(iter, XML_AGENT_ATTR_CLASS, rsc->standard);
+    crm_xml_add(iter, XML_AGENT_ATTR_PROVIDER, rsc->provider);
+    if (lock_time != 0) {
+        /* Actions on a locked resource should either preserve the lock by
+         * recording it with the action result, or clear it.
+         */
+        if (!should_preserve_lock(op)) {
+            lock_time = 0;
         }
+        crm_xml_add_ll(iter, XML_CONFIG_ATTR_SHUTDOWN_LOCK,
+                       (long long) lock_time);
+    }
 
-    } else {
-        crm_warn("Resource %s no longer exists in the executor", op->rsc_id);
-        controld_ack_event_directly(NULL, NULL, rsc, op, op->rsc_id);
-        goto cleanup;
+    if (op->params) {
+        container = g_hash_table_lookup(op->params, CRM_META"_"XML_RSC_ATTR_CONTAINER);
+    }
+    if (container) {
+        crm_trace("Resource %s is a part of container resource %s", op->rsc_id, container);
+        crm_xml_add(iter, XML_RSC_ATTR_CONTAINER, container);
     }
 
-    crm_log_xml_trace(update, __FUNCTION__);
+    crm_trace("Queued resource state update for %s=%u on %s",
+              op->op_type, op->interval_ms, op->rsc_id);
 
-    /* make it an asynchronous call and be done with it
-     *
-     * Best case:
-     *   the resource state will be discovered during
-     *   the next signup or election.
-     *
-     * Bad case:
-     *   we are shutting down and there is no DC at the time,
-     *   but then why were we shutting down then anyway?
-     *   (probably because of an internal error)
-     *
-     * Worst case:
-     *   we get shot for having resources "running" that really weren't
-     *
-     * the alternative however means blocking here for too long, which
-     * isn't acceptable
-     */
-    fsa_cib_update(XML_CIB_TAG_STATUS, update, call_opt, rc, NULL);
+    if (++resource_update_ops >= RESOURCE_UPDATE_MAX_OPS) {
+        /* Send the update once the current result has been fully processed,
+         * so that its log message can include the call ID
+         */
+        if (resource_update_timer != 0) {
+            g_source_remove(resource_update_timer);
+        }
+        resource_update_timer = g_timeout_add(0, resource_update_timer_cb,
+                                              NULL);
 
-    if (rc > 0) {
-        last_resource_update = rc;
+    } else if (resource_update_timer == 0) {
+        resource_update_timer = g_timeout_add(RESOURCE_UPDATE_DELAY_MS,
+                                              resource_update_timer_cb, NULL);
     }
-  done:
-    /* the return code is a call number, not an error code */
-    crm_trace("Sent resource state update message: %d for %s=%u on %s",
-              rc, op->op_type, op->interval_ms, op->rsc_id);
-    fsa_register_cib_callback(rc, FALSE, NULL, cib_rsc_callback);
-
-  cleanup:
-    free_xml(update);
-    return rc;
+    return TRUE;
 }
 
 void
@@ -2570,10 +2815,11 @@ process_lrm_event(lrm_state_t *lrm_state, lrmd_event_data_t *op,
     char *op_id = NULL;
     char *op_key = NULL;
 
-    int update_id = 0;
     gboolean remove = FALSE;
     gboolean removed = FALSE;
     bool need_direct_ack = FALSE;
+    bool queued = FALSE;
+    char *text = NULL;
     lrmd_rsc_info_t *rsc = NULL;
     const char *node_name = NULL;
 
@@ -2635,6 +2881,32 @@ process_lrm_event(lrm_state_t *lrm_state, lrmd_event_data_t *op,
         }
     }
 
+    /* With lrmd_opt_notify_params_once, repeat results of recurring operations
+     * come without parameters, so use the ones we executed it with, or else
+     * the ones recorded with its last result.
+     */
+    if (op->params == NULL) {
+        lrmd_event_data_t *last = NULL;
+
+        if (pending && pending->params) {
+            op->params = crm_str_table_dup(pending->params);
+
+        } else if (lrm_state
+                   && (last = history_find_recurring_op(lrm_state, op))
+                   && last->params) {
+            op->params = crm_str_table_dup(last->params);
+
+        } else if (op->interval_ms > 0) {
+            /* Without parameters, no digests can be calculated, so record the
+             * result without any rather than with digests of nothing. The
+             * scheduler will reschedule the operation (which gives us its
+             * parameters again) instead of restarting the resource.
+             */
+            crm_warn("Recording result of %s without digests because its "
+                     "parameters are unknown", op_key);
+        }
+    }
+
     if (op->op_status == PCMK_LRM_OP_ERROR) {
         switch(op->rc) {
             case PCMK_OCF_NOT_RUNNING:
@@ -2660,8 +2932,8 @@ process_lrm_event(lrm_state_t *lrm_state, lrmd_event_data_t *op,
         if (controld_action_is_recordable(op->op_type)) {
             if (node_name && rsc) {
                 // We should record the result, and happily, we can
-                update_id = do_update_resource(node_name, rsc, op,
-                                               pending? pending->lock_time : 0);
+                queued = do_update_resource(node_name, rsc, op,
+                                            pending? pending->lock_time : 0);
                 need_direct_ack = FALSE;
 
             } else if (op->rsc_deleted) {
@@ -2777,13 +3049,14 @@ process_lrm_event(lrm_state_t *lrm_state, lrmd_event_data_t *op,
             break;
 
         case PCMK_LRM_OP_DONE:
-            crm_notice("Result of %s operation for %s on %s: %s "
-                       CRM_XS " rc=%d call=%d key=%s confirmed=%s cib-update=%d",
-                       crm_action_str(op->op_type, op->interval_ms),
-                       op->rsc_id, node_name,
-                       services_ocf_exitcode_str(op->rc), op->rc,
-                       op->call_id, op_key, (removed? "true" : "false"),
-                       update_id);
+            text = crm_strdup_printf("Result of %s operation for %s on %s: %s "
+                                     CRM_XS " rc=%d call=%d key=%s confirmed=%s",
+                                     crm_action_str(op->op_type, op->interval_ms),
+                                     op->rsc_id, node_name,
+                                     services_ocf_exitcode_str(op->rc), op->rc,
+                                     op->call_id, op_key,
+                                     (removed? "true" : "false"));
+            log_recorded_result(LOG_NOTICE, queued, text);
             break;
 
         case PCMK_LRM_OP_TIMEOUT:
@@ -2796,12 +3069,15 @@ process_lrm_event(lrm_state_t *lrm_state, lrmd_event_data_t *op,
             break;
 
         default:
-            crm_err("Result of %s operation for %s on %s: %s "
-                    CRM_XS " call=%d key=%s confirmed=%s status=%d cib-update=%d",
-                    crm_action_str(op->op_type, op->interval_ms),
-                    op->rsc_id, node_name,
-                    services_lrm_status_str(op->op_status), op->call_id, op_key,
-                    (removed? "true" : "false"), op->op_status, update_id);
+            text = crm_strdup_printf("Result of %s operation for %s on %s: %s "
+                                     CRM_XS " call=%d key=%s confirmed=%s "
+                                     "status=%d",
+                                     crm_action_str(op->op_type, op->interval_ms),
+                                     op->rsc_id, node_name,
+                                     services_lrm_status_str(op->op_status),
+                                     op->call_id, op_key,
+                                     (removed? "true" : "false"), op->op_status);
+            log_recorded_result(LOG_ERR, queued, text);
     }
 
     if (op->output) {
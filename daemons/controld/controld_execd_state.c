@@ -702,7 +702,9 @@ lrm_state_exec(lrm_state_t *lrm_state, const char *rsc_id, const char *action,
                                                     interval_ms,
                                                     timeout,
                                                     start_delay,
-                                                    lrmd_opt_notify_changes_only, params);
+                                                    lrmd_opt_notify_changes_only
+                                                    |lrmd_opt_notify_params_once,
+                                                    params);
 }
 
 int
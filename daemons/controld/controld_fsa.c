@@ -176,10 +176,11 @@ s_crmd_fsa(enum crmd_fsa_cause cause)
         fsa_data->origin = __FUNCTION__;
         fsa_data->data_type = fsa_dt_none;
         fsa_message_queue = g_list_append(fsa_message_queue, fsa_data);
+        controld_metrics_queue_depth(++fsa_message_queue_len);
         fsa_data = NULL;
     }
     while ((fsa_message_queue != NULL) && !do_fsa_stall) {
-        crm_trace("Checking messages (%d remaining)", g_list_length(fsa_message_queue));
+        crm_trace("Checking messages (%u remaining)", fsa_message_queue_len);
 
         fsa_data = get_message();
         if(fsa_data == NULL) {
@@ -231,6 +232,7 @@ s_crmd_fsa(enum crmd_fsa_cause cause)
          * Allows actions to be added or removed when entering a state
          */
         if (last_state != fsa_state) {
+            controld_metrics_state_change(last_state, fsa_state);
             fsa_actions = do_state_transition(fsa_actions, last_state, fsa_state, fsa_data);
         } else {
             do_dot_log(DOT_PREFIX "\t// FSA input: State=%s \tCause=%s"
@@ -248,8 +250,8 @@ s_crmd_fsa(enum crmd_fsa_cause cause)
 
     if ((fsa_message_queue != NULL) || (fsa_actions != A_NOTHING)
         || do_fsa_stall) {
-        crm_debug("Exiting the FSA: queue=%d, fsa_actions=0x%llx, stalled=%s",
-                  g_list_length(fsa_message_queue), fsa_actions, do_fsa_stall ? "true" : "false");
+        crm_debug("Exiting the FSA: queue=%u, fsa_actions=0x%llx, stalled=%s",
+                  fsa_message_queue_len, fsa_actions, do_fsa_stall ? "true" : "false");
     } else {
         crm_trace("Exiting the FSA");
     }
@@ -212,6 +212,65 @@ set_join_state(const char * start_state)
     }
 }
 
+/*!
+ * \internal
+ * \brief Remove resource histories that the CIB already has from node state
+ *
+ * \param[in,out] state    Node state XML with this node's resource history
+ * \param[in]     digests  Digests of this node's resource histories in the CIB
+ *
+ * \return Newly allocated XML listing the resource histories that were
+ *         removed, which the DC must keep in the CIB (caller is responsible
+ *         for freeing)
+ */
+static xmlNode *
+drop_unchanged_history(xmlNode *state, xmlNode *digests)
+{
+    GHashTable *cib_digests = crm_str_table_new();
+    xmlNode *unchanged_xml = create_xml_node(NULL, XML_LRM_TAG_RESOURCES);
+    xmlNode *rsc_list = first_named_child(first_named_child(state,
+                                                            XML_CIB_TAG_LRM),
+                                          XML_LRM_TAG_RESOURCES);
+    xmlNode *rsc = NULL;
+    xmlNode *next = NULL;
+    int unchanged = 0;
+
+    for (rsc = first_named_child(digests, XML_LRM_TAG_RESOURCE); rsc != NULL;
+         rsc = crm_next_same_xml(rsc)) {
+
+        const char *digest = crm_element_value(rsc, XML_ATTR_DIGEST);
+
+        if ((ID(rsc) != NULL) && (digest != NULL)) {
+            g_hash_table_insert(cib_digests, strdup(ID(rsc)), strdup(digest));
+        }
+    }
+
+    for (rsc = first_named_child(rsc_list, XML_LRM_TAG_RESOURCE); rsc != NULL;
+         rsc = next) {
+
+        const char *cib_digest = NULL;
+
+        next = crm_next_same_xml(rsc);
+        cib_digest = g_hash_table_lookup(cib_digests, crm_str(ID(rsc)));
+        if (cib_digest != NULL) {
+            char *digest = pcmk__rsc_history_digest(rsc);
+
+            if (safe_str_eq(digest, cib_digest)) {
+                crm_xml_add(create_xml_node(unchanged_xml,
+                                            XML_LRM_TAG_RESOURCE),
+                            XML_ATTR_ID, ID(rsc));
+                free_xml(rsc);
+                unchanged++;
+            }
+            free(digest);
+        }
+    }
+    crm_debug("Omitting %d resource histor%s already in CIB from join "
+              "confirmation", unchanged, ((unchanged == 1)? "y" : "ies"));
+    g_hash_table_destroy(cib_digests);
+    return unchanged_xml;
+}
+
 /*	A_CL_JOIN_RESULT	*/
 /* aka. this is notification that we have (or have not) been accepted */
 void
@@ -266,10 +325,24 @@ do_cl_join_finalize_respond(long long action,
     /* send our status section to the DC */
     tmp1 = controld_query_executor_state(fsa_our_uname);
     if (tmp1 != NULL) {
-        xmlNode *reply = create_request(CRM_OP_JOIN_CONFIRM, tmp1, fsa_our_dc,
-                                        CRM_SYSTEM_DC, CRM_SYSTEM_CRMD, NULL);
+        xmlNode *reply = NULL;
+        xmlNode *unchanged = NULL;
 
+        /* If the DC told us what resource history the CIB already has, send
+         * only what differs, along with what the DC can keep.
+         */
+        if (safe_str_eq(crm_element_name(input->xml),
+                        PCMK__XE_HISTORY_DIGESTS)) {
+            unchanged = drop_unchanged_history(tmp1, input->xml);
+        }
+
+        reply = create_request(CRM_OP_JOIN_CONFIRM, tmp1, fsa_our_dc,
+                               CRM_SYSTEM_DC, CRM_SYSTEM_CRMD, NULL);
         crm_xml_add_int(reply, F_CRM_JOIN_ID, join_id);
+        if (unchanged != NULL) {
+            add_message_xml(reply, PCMK__XE_UNCHANGED_HISTORY, unchanged);
+            free_xml(unchanged);
+        }
 
         crm_debug("Confirming join-%d: sending local operation history to %s",
                   join_id, fsa_our_dc);
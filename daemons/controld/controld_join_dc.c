@@ -23,6 +23,7 @@ xmlNode *max_generation_xml = NULL;
 
 void finalize_join_for(gpointer key, gpointer value, gpointer user_data);
 void finalize_sync_callback(xmlNode * msg, int call_id, int rc, xmlNode * output, void *user_data);
+static void finalize_join_with_history(void);
 gboolean check_join_state(enum crmd_fsa_state cur_state, const char *source);
 
 /* Numeric counter used to identify join rounds (an unsigned int would be
@@ -500,11 +501,68 @@ finalize_sync_callback(xmlNode * msg, int call_id, int rc, xmlNode * output, voi
             crm_debug("Notifying %d node%s of join-%d results",
                       count_integrated, pcmk__plural_s(count_integrated),
                       current_join_id);
-            g_hash_table_foreach(crm_peer_cache, finalize_join_for, NULL);
+            finalize_join_with_history();
         }
     }
 }
 
+/*!
+ * \internal
+ * \brief Notify integrated nodes of join results, using queried node history
+ *
+ * \param[in] msg        Ignored
+ * \param[in] call_id    Ignored
+ * \param[in] rc         Result of CIB status section query
+ * \param[in] output     CIB status section (if query succeeded)
+ * \param[in] user_data  Join ID that query was for (as string)
+ */
+static void
+finalize_join_history_callback(xmlNode *msg, int call_id, int rc,
+                               xmlNode *output, void *user_data)
+{
+    int join_id = crm_parse_int((const char *) user_data, "-1");
+
+    if (!AM_I_DC || (fsa_state != S_FINALIZE_JOIN)
+        || (join_id != current_join_id)) {
+        crm_debug("Ignoring node history for join-%d because no longer "
+                  "finalizing it", join_id);
+        return;
+    }
+    if (rc != pcmk_ok) {
+        crm_warn("Nodes will send full resource history for join-%d "
+                 "because CIB status could not be read: %s",
+                 join_id, pcmk_strerror(rc));
+        output = NULL;
+    }
+    g_hash_table_foreach(crm_peer_cache, finalize_join_for, output);
+}
+
+/*!
+ * \internal
+ * \brief Notify integrated nodes of join results
+ *
+ * Each node's acknowledgement lists digests of the resource histories the CIB
+ * already has for it, so the node can send only the histories that differ.
+ * This requires reading the CIB status section first. If shutdown locks are
+ * enabled, locked resources' history is handled specially when a node joins,
+ * so the full history is used instead.
+ */
+static void
+finalize_join_with_history(void)
+{
+    int rc = pcmk_ok;
+
+    if (controld_shutdown_lock_enabled) {
+        g_hash_table_foreach(crm_peer_cache, finalize_join_for, NULL);
+        return;
+    }
+    rc = fsa_cib_conn->cmds->query(fsa_cib_conn, XML_CIB_TAG_STATUS, NULL,
+                                   cib_scope_local);
+    fsa_register_cib_callback(rc, FALSE,
+                              crm_strdup_printf("%d", current_join_id),
+                              finalize_join_history_callback);
+}
+
 static void
 join_update_complete_callback(xmlNode * msg, int call_id, int rc, xmlNode * output, void *user_data)
 {
@@ -535,6 +593,7 @@ do_dc_join_ack(long long action,
     int call_id = 0;
     ha_msg_input_t *join_ack = fsa_typed_data(fsa_dt_ha_msg);
     enum controld_section_e section = controld_section_lrm;
+    xmlNode *unchanged = NULL;
 
     const char *op = crm_element_value(join_ack->msg, F_CRM_TASK);
     const char *join_from = crm_element_value(join_ack->msg, F_CRM_HOST_FROM);
@@ -587,7 +646,17 @@ do_dc_join_ack(long long action,
     if (controld_shutdown_lock_enabled) {
         section = controld_section_lrm_unlocked;
     }
-    controld_delete_node_state(join_from, section, cib_scope_local);
+    unchanged = get_message_xml(join_ack->msg, PCMK__XE_UNCHANGED_HISTORY);
+    if ((unchanged != NULL) && safe_str_neq(join_from, fsa_our_uname)) {
+        /* The node left out the resource histories that match the CIB, so
+         * erase everything else. This includes any history that reached the
+         * CIB after the status query that the digests came from.
+         */
+        controld_delete_node_history_except(join_from, unchanged,
+                                            cib_scope_local);
+    } else {
+        controld_delete_node_state(join_from, section, cib_scope_local);
+    }
     if (safe_str_eq(join_from, fsa_our_uname)) {
         xmlNode *now_dc_lrmd_state = controld_query_executor_state(fsa_our_uname);
 
@@ -612,6 +681,54 @@ do_dc_join_ack(long long action,
     fsa_register_cib_callback(call_id, FALSE, NULL, join_update_complete_callback);
 }
 
+/*!
+ * \internal
+ * \brief Create XML with digests of a node's resource histories in the CIB
+ *
+ * \param[in] status  CIB status section
+ * \param[in] uname   Name of node to list resource histories for
+ *
+ * \return Newly allocated XML (caller is responsible for freeing)
+ */
+static xmlNode *
+history_digests_xml(xmlNode *status, const char *uname)
+{
+    xmlNode *digests = create_xml_node(NULL, PCMK__XE_HISTORY_DIGESTS);
+    xmlNode *rsc_list = NULL;
+
+    for (xmlNode *state = first_named_child(status, XML_CIB_TAG_STATE);
+         state != NULL; state = crm_next_same_xml(state)) {
+
+        if (safe_str_eq(crm_element_value(state, XML_ATTR_UNAME), uname)) {
+            rsc_list = first_named_child(first_named_child(state,
+                                                           XML_CIB_TAG_LRM),
+                                         XML_LRM_TAG_RESOURCES);
+            break;
+        }
+    }
+
+    for (xmlNode *rsc = first_named_child(rsc_list, XML_LRM_TAG_RESOURCE);
+         rsc != NULL; rsc = crm_next_same_xml(rsc)) {
+
+        xmlNode *entry = create_xml_node(digests, XML_LRM_TAG_RESOURCE);
+        char *digest = pcmk__rsc_history_digest(rsc);
+
+        crm_xml_add(entry, XML_ATTR_ID, ID(rsc));
+        crm_xml_add(entry, XML_ATTR_DIGEST, digest);
+        free(digest);
+    }
+    return digests;
+}
+
+/*!
+ * \internal
+ * \brief Acknowledge an integrated node's join request
+ *
+ * \param[in] key        Ignored
+ * \param[in] value      Node to acknowledge
+ * \param[in] user_data  CIB status section to take history digests from
+ *                       (or NULL to have the node send its full history)
+ */
 void
 finalize_join_for(gpointer key, gpointer value, gpointer user_data)
 {
@@ -654,6 +771,12 @@ finalize_join_for(gpointer key, gpointer value, gpointer user_data)
               current_join_id, join_to);
     acknak = create_dc_message(CRM_OP_JOIN_ACKNAK, join_to);
     crm_xml_add(acknak, CRM_OP_JOIN_ACKNAK, XML_BOOLEAN_TRUE);
+    if (user_data != NULL) {
+        xmlNode *digests = history_digests_xml((xmlNode *) user_data, join_to);
+
+        add_message_xml(acknak, F_CRM_DATA, digests);
+        free_xml(digests);
+    }
     crm_update_peer_join(__FUNCTION__, join_node, crm_join_finalized);
     crm_update_peer_expected(__FUNCTION__, join_node, CRMD_JOINSTATE_MEMBER);
 
@@ -24,7 +24,11 @@ typedef struct resource_history_s {
     lrmd_rsc_info_t rsc;
     lrmd_event_data_t *last;
     lrmd_event_data_t *failed;
-    GList *recurring_op_list;
+    GHashTable *recurring_ops;  // Key: operation key, value: lrmd_event_data_t*
+
+    /* Resource history XML as last sent to the CIB, regenerated only when this
+     * resource's history changes (NULL if not yet built or out of date) */
+    xmlNode *xml;
 
     /* Resources must be stopped using the same
      * parameters they were started with.  This hashtable
@@ -23,6 +23,7 @@
 #include <pacemaker-controld.h>
 
 GListPtr fsa_message_queue = NULL;
+guint fsa_message_queue_len = 0;
 extern void crm_shutdown(int nsig);
 
 static enum crmd_fsa_input handle_message(xmlNode *msg,
@@ -61,7 +62,7 @@ register_fsa_input_adv(enum crmd_fsa_cause cause, enum crmd_fsa_input input,
                        void *data, long long with_actions,
                        gboolean prepend, const char *raised_from)
 {
-    unsigned old_len = g_list_length(fsa_message_queue);
+    unsigned old_len = fsa_message_queue_len;
     fsa_data_t *fsa_data = NULL;
 
     if (raised_from == NULL) {
@@ -152,16 +153,12 @@ register_fsa_input_adv(enum crmd_fsa_cause cause, enum crmd_fsa_input input,
     } else {
         fsa_message_queue = g_list_append(fsa_message_queue, fsa_data);
     }
+    controld_metrics_queue_depth(++fsa_message_queue_len);
 
-    crm_trace("FSA message queue length is %d",
-              g_list_length(fsa_message_queue));
+    crm_trace("FSA message queue length is %u", fsa_message_queue_len);
 
     /* fsa_dump_queue(LOG_TRACE); */
 
-    if (old_len == g_list_length(fsa_message_queue)) {
-        crm_err("Couldn't add message to the queue");
-    }
-
     if (fsa_source && input != I_WAIT_FOR_EVENT) {
         crm_trace("Triggering FSA");
         mainloop_set_trigger(fsa_source);
@@ -245,6 +242,9 @@ get_message(void)
     fsa_data_t *message = g_list_nth_data(fsa_message_queue, 0);
 
     fsa_message_queue = g_list_remove(fsa_message_queue, message);
+    if (message != NULL) {
+        controld_metrics_queue_depth(--fsa_message_queue_len);
+    }
     crm_trace("Processing input %d", message->id);
     return message;
 }
@@ -776,6 +776,48 @@ handle_ping(xmlNode *msg)
     return I_NULL;
 }
 
+/*!
+ * \brief Handle a CRM_OP_JOB_LIMITS request
+ *
+ * \param[in] msg  Message XML
+ *
+ * \return Next FSA input
+ */
+static enum crmd_fsa_input
+handle_job_limits_request(xmlNode *msg)
+{
+    xmlNode *limits = throttle_job_limits_xml();
+
+    msg = create_reply(msg, limits);
+    free_xml(limits);
+    if (msg) {
+        (void) relay_message(msg, TRUE);
+        free_xml(msg);
+    }
+    return I_NULL;
+}
+
+/*!
+ * \brief Handle a CRM_OP_METRICS request
+ *
+ * \param[in] msg  Message XML
+ *
+ * \return Next FSA input
+ */
+static enum crmd_fsa_input
+handle_metrics_request(xmlNode *msg)
+{
+    xmlNode *metrics = controld_metrics_xml();
+
+    msg = create_reply(msg, metrics);
+    free_xml(metrics);
+    if (msg) {
+        (void) relay_message(msg, TRUE);
+        free_xml(msg);
+    }
+    return I_NULL;
+}
+
 /*!
  * \brief Handle a CRM_OP_NODE_INFO request
  *
@@ -965,6 +1007,9 @@ handle_request(xmlNode *stored_msg, enum crmd_fsa_cause cause)
         } else if (strcmp(op, CRM_OP_REMOTE_STATE) == 0) {
             /* a remote connection host is letting us know the node state */
             return handle_remote_state(stored_msg);
+
+        } else if (strcmp(op, CRM_OP_JOB_LIMITS) == 0) {
+            return handle_job_limits_request(stored_msg);
         }
     }
 
@@ -1042,6 +1087,9 @@ handle_request(xmlNode *stored_msg, enum crmd_fsa_cause cause)
     } else if (strcmp(op, CRM_OP_NODE_INFO) == 0) {
         return handle_node_info_request(stored_msg);
 
+    } else if (strcmp(op, CRM_OP_METRICS) == 0) {
+        return handle_metrics_request(stored_msg);
+
     } else if (strcmp(op, CRM_OP_RM_NODE_CACHE) == 0) {
         int id = 0;
         const char *name = NULL;
@@ -1103,10 +1151,20 @@ handle_response(xmlNode *stored_msg)
         if (msg_ref == NULL) {
             crm_err("%s - Ignoring calculation with no reference", op);
 
+        } else if (safe_str_eq(msg_ref, fsa_pe_ref)
+                   && crm_is_true(crm_element_value(stored_msg,
+                                                    PCMK__XA_NEED_FULL_INPUT))) {
+            crm_info("Scheduler could not use incremental input, "
+                     "resending full CIB " CRM_XS " ref=%s", msg_ref);
+            controld_stop_sched_timer();
+            controld_sched_need_full_input();
+            register_fsa_action(A_PE_INVOKE);
+
         } else if (safe_str_eq(msg_ref, fsa_pe_ref)) {
             ha_msg_input_t fsa_input;
 
             controld_stop_sched_timer();
+            controld_metrics_sched_reply();
             fsa_input.msg = stored_msg;
             register_fsa_input_later(C_IPC_MESSAGE, I_PE_SUCCESS, &fsa_input);
 
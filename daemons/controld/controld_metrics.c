@@ -0,0 +1,292 @@
+/*
+ * Copyright 2020 the Pacemaker project contributors
+ *
+ * The version control history for this file may have further details.
+ *
+ * This source code is licensed under the GNU General Public License version 2
+ * or later (GPLv2+) WITHOUT ANY WARRANTY.
+ */
+
+#include <crm_internal.h>
+
+#include <crm/crm.h>
+#include <crm/msg_xml.h>
+
+#include <pacemaker-controld.h>
+
+/* Latency counters kept in memory since the controller started. Nothing here
+ * is persisted or shared with peers; crmadmin --metrics asks a controller for
+ * its own view.
+ */
+
+struct latency_s {
+    guint count;
+    long long total_ms;
+    long long max_ms;
+    long long last_ms;
+};
+
+// Upper bounds (exclusive) of all but the last action latency bucket
+static const long long bucket_upper_ms[] = { 100, 1000, 10000, 60000, 300000 };
+
+#define N_BUCKETS \
+    ((int) (sizeof(bucket_upper_ms) / sizeof(bucket_upper_ms[0])) + 1)
+
+struct action_latency_s {
+    struct latency_s latency;
+    guint buckets[N_BUCKETS];
+};
+
+// FSA state dwell times (indexed by state)
+static struct latency_s state_dwell[MAXSTATE];
+static enum crmd_fsa_state metrics_state = S_STARTING;
+static long long state_entered_ms = 0;
+
+// FSA input queue depth
+static guint queue_depth = 0;
+static guint queue_max = 0;
+
+// Scheduler round trips
+static struct latency_s sched_latency;
+static long long sched_request_ms = 0;
+
+// Action latency (key: task name, value: struct action_latency_s *)
+static GHashTable *action_latency = NULL;
+
+// Transition aborts (key: reason, value: count)
+static GHashTable *abort_counts = NULL;
+
+static long long
+now_ms(void)
+{
+    return g_get_monotonic_time() / 1000;
+}
+
+static void
+latency_add(struct latency_s *latency, long long ms)
+{
+    latency->count++;
+    latency->total_ms += ms;
+    latency->last_ms = ms;
+    if (ms > latency->max_ms) {
+        latency->max_ms = ms;
+    }
+}
+
+static void
+latency_to_xml(xmlNode *xml, struct latency_s *latency)
+{
+    crm_xml_add_int(xml, PCMK__XA_COUNT, latency->count);
+    crm_xml_add_ll(xml, PCMK__XA_TOTAL_MS, latency->total_ms);
+    crm_xml_add_ll(xml, PCMK__XA_MAX_MS, latency->max_ms);
+    crm_xml_add_ll(xml, PCMK__XA_LAST_MS, latency->last_ms);
+}
+
+/*!
+ * \internal
+ * \brief Record the time spent in an FSA state being left
+ *
+ * \param[in] last_state  State being left
+ * \param[in] next_state  State being entered
+ */
+void
+controld_metrics_state_change(enum crmd_fsa_state last_state,
+                              enum crmd_fsa_state next_state)
+{
+    long long now = now_ms();
+
+    /* The time spent in the initial state before the first transition isn't
+     * known, so it isn't counted.
+     */
+    if ((state_entered_ms > 0) && (last_state < MAXSTATE)) {
+        latency_add(&(state_dwell[last_state]), now - state_entered_ms);
+    }
+    metrics_state = next_state;
+    state_entered_ms = now;
+}
+
+/*!
+ * \internal
+ * \brief Record the current length of the FSA input queue
+ *
+ * \param[in] depth  Number of inputs queued
+ */
+void
+controld_metrics_queue_depth(guint depth)
+{
+    queue_depth = depth;
+    if (depth > queue_max) {
+        queue_max = depth;
+    }
+}
+
+/*!
+ * \internal
+ * \brief Record that a calculation request was sent to the scheduler
+ */
+void
+controld_metrics_sched_request(void)
+{
+    sched_request_ms = now_ms();
+}
+
+/*!
+ * \internal
+ * \brief Record that the scheduler replied to the expected request
+ */
+void
+controld_metrics_sched_reply(void)
+{
+    if (sched_request_ms > 0) {
+        latency_add(&sched_latency, now_ms() - sched_request_ms);
+        sched_request_ms = 0;
+    }
+}
+
+/*!
+ * \internal
+ * \brief Record the time between initiating and confirming a graph action
+ *
+ * \param[in] action  Action being confirmed
+ */
+void
+controld_metrics_action_confirmed(crm_action_t *action)
+{
+    const char *task = NULL;
+    struct action_latency_s *entry = NULL;
+    long long ms = 0;
+    int bucket = 0;
+
+    if ((action->type == action_type_pseudo) || (action->initiated_ms == 0)) {
+        return;
+    }
+    task = crm_element_value(action->xml, XML_LRM_ATTR_TASK);
+    if (task == NULL) {
+        return;
+    }
+
+    if (action_latency == NULL) {
+        action_latency = g_hash_table_new_full(crm_str_hash, g_str_equal,
+                                               free, free);
+    }
+    entry = g_hash_table_lookup(action_latency, task);
+    if (entry == NULL) {
+        entry = calloc(1, sizeof(struct action_latency_s));
+        CRM_ASSERT(entry != NULL);
+        g_hash_table_insert(action_latency, strdup(task), entry);
+    }
+
+    ms = now_ms() - action->initiated_ms;
+    latency_add(&(entry->latency), ms);
+    while ((bucket < N_BUCKETS - 1) && (ms >= bucket_upper_ms[bucket])) {
+        bucket++;
+    }
+    entry->buckets[bucket]++;
+}
+
+/*!
+ * \internal
+ * \brief Count a transition abort by its reason
+ *
+ * \param[in] reason  Text describing why the transition was aborted
+ */
+void
+controld_metrics_abort(const char *reason)
+{
+    guint count = 0;
+
+    if (reason == NULL) {
+        reason = "unknown";
+    }
+    if (abort_counts == NULL) {
+        abort_counts = g_hash_table_new_full(crm_str_hash, g_str_equal,
+                                             free, NULL);
+    }
+    count = GPOINTER_TO_UINT(g_hash_table_lookup(abort_counts, reason));
+    g_hash_table_insert(abort_counts, strdup(reason),
+                        GUINT_TO_POINTER(count + 1));
+}
+
+/*!
+ * \internal
+ * \brief Create XML describing the controller's metrics
+ *
+ * \return Newly created XML (caller is responsible for freeing with free_xml())
+ */
+xmlNode *
+controld_metrics_xml(void)
+{
+    xmlNode *xml = create_xml_node(NULL, PCMK__XE_CONTROLLER_METRICS);
+    xmlNode *child = NULL;
+    GHashTableIter iter;
+    gpointer key = NULL;
+    gpointer value = NULL;
+
+    child = create_xml_node(xml, PCMK__XE_FSA);
+    crm_xml_add(child, XML_PING_ATTR_CRMDSTATE,
+                fsa_state2string(metrics_state));
+    if (state_entered_ms > 0) {
+        crm_xml_add_ll(child, PCMK__XA_CURRENT_MS,
+                       now_ms() - state_entered_ms);
+    }
+    crm_xml_add_int(child, PCMK__XA_QUEUE_DEPTH, queue_depth);
+    crm_xml_add_int(child, PCMK__XA_QUEUE_MAX, queue_max);
+    for (int state = 0; state < MAXSTATE; state++) {
+        xmlNode *state_xml = NULL;
+
+        if (state_dwell[state].count == 0) {
+            continue;
+        }
+        state_xml = create_xml_node(child, PCMK__XE_FSA_STATE);
+        crm_xml_add(state_xml, XML_NVPAIR_ATTR_NAME, fsa_state2string(state));
+        latency_to_xml(state_xml, &(state_dwell[state]));
+    }
+
+    child = create_xml_node(xml, PCMK__XE_SCHEDULER);
+    latency_to_xml(child, &sched_latency);
+
+    if (action_latency != NULL) {
+        g_hash_table_iter_init(&iter, action_latency);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            struct action_latency_s *entry = value;
+
+            child = create_xml_node(xml, PCMK__XE_ACTION_LATENCY);
+            crm_xml_add(child, PCMK__XA_TASK, (const char *) key);
+            latency_to_xml(child, &(entry->latency));
+            for (int bucket = 0; bucket < N_BUCKETS; bucket++) {
+                xmlNode *bucket_xml = create_xml_node(child,
+                                                      PCMK__XE_LATENCY_BUCKET);
+
+                if (bucket < N_BUCKETS - 1) {
+                    crm_xml_add_ll(bucket_xml, PCMK__XA_UPPER_MS,
+                                   bucket_upper_ms[bucket]);
+                }
+                crm_xml_add_int(bucket_xml, PCMK__XA_COUNT,
+                                entry->buckets[bucket]);
+            }
+        }
+    }
+
+    if (abort_counts != NULL) {
+        g_hash_table_iter_init(&iter, abort_counts);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            child = create_xml_node(xml, PCMK__XE_TRANSITION_ABORT);
+            crm_xml_add(child, PCMK__XA_REASON, (const char *) key);
+            crm_xml_add_int(child, PCMK__XA_COUNT, GPOINTER_TO_UINT(value));
+        }
+    }
+    return xml;
+}
+
+void
+controld_metrics_fini(void)
+{
+    if (action_latency != NULL) {
+        g_hash_table_destroy(action_latency);
+        action_latency = NULL;
+    }
+    if (abort_counts != NULL) {
+        g_hash_table_destroy(abort_counts);
+        abort_counts = NULL;
+    }
+}
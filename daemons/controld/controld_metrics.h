@@ -0,0 +1,28 @@
+/*
+ * Copyright 2020 the Pacemaker project contributors
+ *
+ * The version control history for this file may have further details.
+ *
+ * This source code is licensed under the GNU Lesser General Public License
+ * version 2.1 or later (LGPLv2.1+) WITHOUT ANY WARRANTY.
+ */
+
+#ifndef CONTROLD_METRICS__H
+#  define CONTROLD_METRICS__H
+
+#include <glib.h>                   // guint
+#include <libxml/tree.h>            // xmlNode
+#include <pacemaker-internal.h>     // crm_action_t
+#include <controld_fsa.h>           // enum crmd_fsa_state
+
+void controld_metrics_state_change(enum crmd_fsa_state last_state,
+                                   enum crmd_fsa_state next_state);
+void controld_metrics_queue_depth(guint depth);
+void controld_metrics_sched_request(void);
+void controld_metrics_sched_reply(void);
+void controld_metrics_action_confirmed(crm_action_t *action);
+void controld_metrics_abort(const char *reason);
+xmlNode *controld_metrics_xml(void);
+void controld_metrics_fini(void);
+
+#endif
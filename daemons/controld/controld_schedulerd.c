@@ -9,11 +9,13 @@
 
 #include <crm_internal.h>
 
-#include <unistd.h>  /* pid_t, sleep, ssize_t */
+#include <unistd.h>  /* pid_t, ssize_t */
 
 #include <crm/cib.h>
 #include <crm/cluster.h>
+#include <crm/common/ipc_internal.h>
 #include <crm/common/xml.h>
+#include <crm/common/xml_internal.h>
 #include <crm/crm.h>
 #include <crm/msg_xml.h>
 
@@ -21,6 +23,132 @@
 
 static mainloop_io_t *pe_subsystem = NULL;
 
+/* If other CIB updates are pending when the scheduler would be invoked, the
+ * invocation waits (without blocking the main loop) until they complete, so
+ * the scheduler sees their results. The wait is limited in case an update
+ * never completes.
+ */
+static mainloop_timer_t *pe_gate_timer = NULL;
+static gint64 pe_gate_start = 0;            // When wait began (0 if none)
+static bool pe_gate_expired = FALSE;        // Whether last wait hit the limit
+static unsigned int pe_gate_delays = 0;     // Number of delayed invocations
+static long long pe_gate_delay_ms = 0;      // Total delay of invocations
+
+#define PE_GATE_MAX_MS (10000)
+
+static void end_pe_gate_wait(bool reinvoke);
+
+/* Rather than query the full CIB every time the scheduler is invoked, the DC
+ * keeps a replica up to date from diff notifications, and the scheduler keeps
+ * the last input it was given. After the first full input, only the patchsets
+ * applied since the previous request need to be sent.
+ */
+static xmlNode *cib_replica = NULL;     // Last known CIB contents (unmodified)
+static GList *sched_patches = NULL;     // Patchsets not yet sent to scheduler
+static int sched_npatches = 0;          // Length of sched_patches
+static bool sched_has_base = FALSE;     // Whether scheduler has a base input
+
+// Past this, sending the full CIB is likely cheaper than the patchsets
+#define SCHED_MAX_PATCHES 100
+
+/*!
+ * \internal
+ * \brief Forget what input the scheduler has, so the next request is full
+ */
+static void
+forget_sched_input(void)
+{
+    g_list_free_full(sched_patches, (GDestroyNotify) free_xml);
+    sched_patches = NULL;
+    sched_npatches = 0;
+    sched_has_base = FALSE;
+}
+
+/*!
+ * \internal
+ * \brief Discard the CIB replica, so the next invocation does a full query
+ */
+static void
+drop_cib_replica(void)
+{
+    free_xml(cib_replica);
+    cib_replica = NULL;
+    forget_sched_input();
+}
+
+/*!
+ * \internal
+ * \brief Apply a CIB diff notification to the scheduler's CIB replica
+ *
+ * \param[in] msg  CIB diff notification
+ */
+void
+controld_sched_cib_updated(xmlNode *msg)
+{
+    int rc = pcmk_ok;
+    xmlNode *patchset = NULL;
+
+    if (cib_replica == NULL) {
+        return;
+    }
+
+    crm_element_value_int(msg, F_CIB_RC, &rc);
+    if (rc != pcmk_ok) {
+        return; // Failed updates don't change the CIB
+    }
+
+    patchset = get_message_xml(msg, F_CIB_UPDATE_RESULT);
+    if (patchset == NULL) {
+        rc = -pcmk_err_diff_failed;
+    } else {
+        rc = xml_apply_patchset(cib_replica, patchset, TRUE);
+    }
+
+    switch (rc) {
+        case pcmk_ok:
+            break;
+        case -pcmk_err_old_data:
+            return; // Replica already has this change
+        default:
+            crm_info("Discarding scheduler's copy of the CIB: %s "
+                     CRM_XS " rc=%d", pcmk_strerror(rc), rc);
+            drop_cib_replica();
+            return;
+    }
+
+    if (sched_has_base) {
+        if (sched_npatches >= SCHED_MAX_PATCHES) {
+            forget_sched_input();
+        } else {
+            sched_patches = g_list_prepend(sched_patches, copy_xml(patchset));
+            sched_npatches++;
+        }
+    }
+}
+
+/*!
+ * \internal
+ * \brief Discard the scheduler's CIB replica after a CIB replace
+ */
+void
+controld_sched_cib_replaced(void)
+{
+    drop_cib_replica();
+}
+
+/*!
+ * \internal
+ * \brief Make the next scheduler request include the full CIB
+ *
+ * \note This is intended to be called when the scheduler reports that it could
+ *       not reconstruct its input from the patchsets it was sent.
+ */
+void
+controld_sched_need_full_input(void)
+{
+    forget_sched_input();
+}
+
 /*!
  * \internal
  * \brief Close any scheduler connection and free associated memory
@@ -29,6 +157,9 @@ void
 pe_subsystem_free(void)
 {
     clear_bit(fsa_input_register, R_PE_REQUIRED);
+    drop_cib_replica();
+    end_pe_gate_wait(FALSE);
+    pe_gate_expired = FALSE;
     if (pe_subsystem) {
         controld_expect_sched_reply(NULL);
         mainloop_del_ipc_client(pe_subsystem);
@@ -84,6 +215,9 @@ pe_ipc_destroy(gpointer user_data)
     // If we aren't connected to the scheduler, we can't expect a reply
     controld_expect_sched_reply(NULL);
 
+    // A new scheduler instance won't have any previous input
+    forget_sched_input();
+
     if (is_set(fsa_input_register, R_PE_REQUIRED)) {
         int rc = pcmk_ok;
         char *uuid_str = crm_generate_uuid();
@@ -119,7 +253,7 @@ pe_ipc_destroy(gpointer user_data)
  * \brief Handle message from scheduler connection
  *
  * \param[in] buffer    XML message (will be freed)
- * \param[in] length    Ignored
+ * \param[in] length    Size of \p buffer in bytes
  * \param[in] userdata  Ignored
  *
  * \return 0
@@ -127,7 +261,7 @@ pe_ipc_destroy(gpointer user_data)
 static int
 pe_ipc_dispatch(const char *buffer, ssize_t length, gpointer userdata)
 {
-    xmlNode *msg = string2xml(buffer);
+    xmlNode *msg = pcmk__xml_from_message(buffer, length);
 
     if (msg) {
         route_message(C_IPC_MESSAGE, msg);
@@ -151,6 +285,7 @@ pe_subsystem_new()
     };
 
     set_bit(fsa_input_register, R_PE_REQUIRED);
+    forget_sched_input();
     pe_subsystem = mainloop_add_ipc_client(CRM_SYSTEM_PENGINE,
                                            G_PRIORITY_DEFAULT,
                                            5 * 1024 * 1024 /* 5MB */,
@@ -158,6 +293,7 @@ pe_subsystem_new()
     if (pe_subsystem == NULL) {
         return FALSE;
     }
+    pcmk__ipc_accept_binary(mainloop_get_ipc_client(pe_subsystem));
     set_bit(fsa_input_register, R_PE_CONNECTED);
     return TRUE;
 }
@@ -215,6 +351,7 @@ do_pe_control(long long action,
 
 int fsa_pe_query = 0;
 char *fsa_pe_ref = NULL;
+static bool fsa_pe_query_full = FALSE;  // Whether fsa_pe_query is full CIB
 static mainloop_timer_t *controld_sched_timer = NULL;
 
 // @TODO Make this a configurable cluster option if there's demand for it
@@ -277,6 +414,7 @@ controld_expect_sched_reply(xmlNode *msg)
                                                       NULL);
         }
         mainloop_timer_start(controld_sched_timer);
+        controld_metrics_sched_request();
     } else {
         controld_stop_sched_timer();
     }
@@ -284,6 +422,87 @@ controld_expect_sched_reply(xmlNode *msg)
     fsa_pe_ref = ref;
 }
 
+/*!
+ * \internal
+ * \brief Stop waiting for pending CIB updates before invoking the scheduler
+ *
+ * \param[in] reinvoke  If TRUE and a wait was in progress, invoke scheduler
+ */
+static void
+end_pe_gate_wait(bool reinvoke)
+{
+    long long waited_ms = 0;
+
+    if (pe_gate_start == 0) {
+        return;
+    }
+    mainloop_timer_stop(pe_gate_timer);
+
+    waited_ms = (g_get_monotonic_time() - pe_gate_start) / 1000;
+    pe_gate_start = 0;
+    pe_gate_delays++;
+    pe_gate_delay_ms += waited_ms;
+
+    crm_info("Scheduler invocation was delayed %lldms by pending CIB updates "
+             CRM_XS " delays=%u total=%lldms",
+             waited_ms, pe_gate_delays, pe_gate_delay_ms);
+    if (reinvoke) {
+        register_fsa_action(A_PE_INVOKE);
+    }
+}
+
+/*!
+ * \internal
+ * \brief Invoke the scheduler despite pending CIB updates
+ *
+ * \param[in] user_data  Ignored
+ *
+ * \return FALSE (indicating that timer should not be restarted)
+ */
+static gboolean
+pe_gate_timeout(gpointer user_data)
+{
+    crm_notice("Invoking scheduler despite %d CIB update%s still pending "
+               "after %dms", num_cib_op_callbacks(),
+               ((num_cib_op_callbacks() == 1)? "" : "s"), PE_GATE_MAX_MS);
+    pe_gate_expired = TRUE;
+    end_pe_gate_wait(TRUE);
+    return FALSE;
+}
+
+/*!
+ * \internal
+ * \brief Wait for pending CIB updates before invoking the scheduler
+ */
+static void
+start_pe_gate_wait(void)
+{
+    if (pe_gate_start != 0) {
+        return; // Already waiting
+    }
+    if (pe_gate_timer == NULL) {
+        pe_gate_timer = mainloop_timer_add("scheduler_cib_wait_timer",
+                                           PE_GATE_MAX_MS, FALSE,
+                                           pe_gate_timeout, NULL);
+    }
+    pe_gate_start = g_get_monotonic_time();
+    mainloop_timer_start(pe_gate_timer);
+}
+
+/*!
+ * \internal
+ * \brief Invoke the scheduler if it was waiting for CIB updates that are done
+ *
+ * \note This is intended to be called after every CIB operation callback.
+ */
+void
+controld_sched_cib_op_done(void)
+{
+    if ((pe_gate_start != 0) && (num_cib_op_callbacks() == 0)) {
+        end_pe_gate_wait(TRUE);
+    }
+}
+
 /*!
  * \internal
  * \brief Free the scheduler reply timer
@@ -295,6 +514,10 @@ controld_free_sched_timer()
         mainloop_timer_del(controld_sched_timer);
         controld_sched_timer = NULL;
     }
+    if (pe_gate_timer != NULL) {
+        mainloop_timer_del(pe_gate_timer);
+        pe_gate_timer = NULL;
+    }
 }
 
 /*	 A_PE_INVOKE	*/
@@ -336,67 +559,89 @@ do_pe_invoke(long long action,
         return;
     }
 
-    fsa_pe_query = fsa_cib_conn->cmds->query(fsa_cib_conn, NULL, NULL, cib_scope_local);
+    if (cib_replica != NULL) {
+        /* The replica is kept current by diff notifications, so only the CIB
+         * version is needed to confirm nothing was missed.
+         */
+        fsa_pe_query = fsa_cib_conn->cmds->query(fsa_cib_conn, NULL, NULL,
+                                                 cib_scope_local|cib_no_children);
+        fsa_pe_query_full = FALSE;
+        crm_debug("Query %d: Requesting the current CIB version: %s",
+                  fsa_pe_query, fsa_state2string(fsa_state));
 
-    crm_debug("Query %d: Requesting the current CIB: %s", fsa_pe_query,
-              fsa_state2string(fsa_state));
+    } else {
+        fsa_pe_query = fsa_cib_conn->cmds->query(fsa_cib_conn, NULL, NULL,
+                                                 cib_scope_local);
+        fsa_pe_query_full = TRUE;
+        crm_debug("Query %d: Requesting the current CIB: %s", fsa_pe_query,
+                  fsa_state2string(fsa_state));
+    }
 
     controld_expect_sched_reply(NULL);
     fsa_register_cib_callback(fsa_pe_query, FALSE, NULL, do_pe_invoke_callback);
 }
 
-static void
-force_local_option(xmlNode *xml, const char *attr_name, const char *attr_value)
+/*!
+ * \internal
+ * \brief Check whether the CIB replica is at least as new as a version query
+ *
+ * \param[in] output  Result of CIB query with cib_no_children
+ *
+ * \return TRUE if the replica is the same version or newer, FALSE otherwise
+ * \note Diff notifications for updates made after the query can arrive before
+ *       its result, so the replica may legitimately be ahead. A gap in the
+ *       notifications is caught when applying the next patchset (which
+ *       discards the replica), so only a replica that is behind the query
+ *       needs to be resynchronized here.
+ */
+static bool
+cib_replica_current(xmlNode *output)
 {
-    int max = 0;
-    int lpc = 0;
-    char *xpath_string = NULL;
-    xmlXPathObjectPtr xpathObj = NULL;
-
-    xpath_string = crm_strdup_printf("%.128s//%s//nvpair[@name='%.128s']",
-                                     get_object_path(XML_CIB_TAG_CRMCONFIG),
-                                     XML_CIB_TAG_PROPSET, attr_name);
-    xpathObj = xpath_search(xml, xpath_string);
-    max = numXpathResults(xpathObj);
-    free(xpath_string);
-
-    for (lpc = 0; lpc < max; lpc++) {
-        xmlNode *match = getXpathResult(xpathObj, lpc);
-        crm_trace("Forcing %s/%s = %s", ID(match), attr_name, attr_value);
-        crm_xml_add(match, XML_NVPAIR_ATTR_VALUE, attr_value);
-    }
-
-    if(max == 0) {
-        xmlNode *configuration = NULL;
-        xmlNode *crm_config = NULL;
-        xmlNode *cluster_property_set = NULL;
-
-        crm_trace("Creating %s-%s for %s=%s",
-                  CIB_OPTIONS_FIRST, attr_name, attr_name, attr_value);
-
-        configuration = find_entity(xml, XML_CIB_TAG_CONFIGURATION, NULL);
-        if (configuration == NULL) {
-            configuration = create_xml_node(xml, XML_CIB_TAG_CONFIGURATION);
-        }
+    int version[3] = { 0, 0, 0 };
+    int replica_version[3] = { 0, 0, 0 };
 
-        crm_config = find_entity(configuration, XML_CIB_TAG_CRMCONFIG, NULL);
-        if (crm_config == NULL) {
-            crm_config = create_xml_node(configuration, XML_CIB_TAG_CRMCONFIG);
-        }
-
-        cluster_property_set = find_entity(crm_config, XML_CIB_TAG_PROPSET, NULL);
-        if (cluster_property_set == NULL) {
-            cluster_property_set = create_xml_node(crm_config, XML_CIB_TAG_PROPSET);
-            crm_xml_add(cluster_property_set, XML_ATTR_ID, CIB_OPTIONS_FIRST);
+    if ((cib_replica == NULL) || (output == NULL)) {
+        return FALSE;
+    }
+    cib_version_details(output, &version[0], &version[1], &version[2]);
+    cib_version_details(cib_replica, &replica_version[0], &replica_version[1],
+                        &replica_version[2]);
+
+    // Compare admin_epoch, then epoch, then num_updates
+    for (int lpc = 0; lpc < DIMOF(version); lpc++) {
+        if (replica_version[lpc] != version[lpc]) {
+            if (replica_version[lpc] < version[lpc]) {
+                crm_debug("CIB replica %d.%d.%d is behind current CIB %d.%d.%d",
+                          replica_version[0], replica_version[1],
+                          replica_version[2], version[0], version[1],
+                          version[2]);
+                return FALSE;
+            }
+            break;
         }
+    }
+    return TRUE;
+}
 
-        xml = create_xml_node(cluster_property_set, XML_CIB_TAG_NVPAIR);
+/*!
+ * \internal
+ * \brief Create XML with the patchsets the scheduler hasn't seen yet
+ *
+ * \return Newly allocated XML for scheduler request data
+ */
+static xmlNode *
+sched_patches_xml(void)
+{
+    xmlNode *patches = create_xml_node(NULL, PCMK__XE_CIB_PATCHES);
 
-        crm_xml_set_id(xml, "%s-%s", CIB_OPTIONS_FIRST, attr_name);
-        crm_xml_add(xml, XML_NVPAIR_ATTR_NAME, attr_name);
-        crm_xml_add(xml, XML_NVPAIR_ATTR_VALUE, attr_value);
+    // The list is newest first, but patchsets must be applied oldest first
+    for (GList *iter = g_list_last(sched_patches); iter != NULL;
+         iter = iter->prev) {
+        add_node_copy(patches, (xmlNode *) iter->data);
     }
-    freeXpathObject(xpathObj);
+    crm_trace("Sending %d CIB patchset%s to scheduler",
+              sched_npatches, ((sched_npatches == 1)? "" : "s"));
+    return patches;
 }
 
 static void
@@ -425,11 +670,10 @@ do_pe_invoke_callback(xmlNode * msg, int call_id, int rc, xmlNode * output, void
         return;
 
     /* this callback counts as 1 */
-    } else if (num_cib_op_callbacks() > 1) {
-        crm_debug("Re-asking for the CIB: %d other peer updates still pending",
+    } else if ((num_cib_op_callbacks() > 1) && !pe_gate_expired) {
+        crm_debug("Re-asking for the CIB once %d other peer updates complete",
                   (num_cib_op_callbacks() - 1));
-        sleep(1);
-        register_fsa_action(A_PE_INVOKE);
+        start_pe_gate_wait();
         return;
 
     } else if (fsa_state != S_POLICY_ENGINE) {
@@ -439,27 +683,61 @@ do_pe_invoke_callback(xmlNode * msg, int call_id, int rc, xmlNode * output, void
 
     CRM_LOG_ASSERT(output != NULL);
 
+    // Any further pending updates will trigger a new transition anyway
+    pe_gate_expired = FALSE;
+    end_pe_gate_wait(FALSE);
+
+    if (fsa_pe_query_full) {
+        drop_cib_replica();
+        cib_replica = copy_xml(output);
+
+    } else if (!cib_replica_current(output)) {
+        crm_info("Re-asking for the full CIB: local copy is out of date");
+        drop_cib_replica();
+        register_fsa_action(A_PE_INVOKE);
+        return;
+    }
+
     /* Refresh the remote node cache and the known node cache when the
      * scheduler is invoked */
-    crm_peer_caches_refresh(output);
+    crm_peer_caches_refresh(cib_replica);
+
+    if (sched_has_base) {
+        xmlNode *patches = sched_patches_xml();
 
-    crm_xml_add(output, XML_ATTR_DC_UUID, fsa_our_uuid);
-    crm_xml_add_int(output, XML_ATTR_HAVE_QUORUM, fsa_has_quorum);
+        cmd = create_request(CRM_OP_PECALC, patches, NULL, CRM_SYSTEM_PENGINE,
+                             CRM_SYSTEM_DC, NULL);
+        free_xml(patches);
+    } else {
+        cmd = create_request(CRM_OP_PECALC, cib_replica, NULL,
+                             CRM_SYSTEM_PENGINE, CRM_SYSTEM_DC, NULL);
+    }
 
-    force_local_option(output, XML_ATTR_HAVE_WATCHDOG, watchdog?"true":"false");
+    /* Controller-supplied values are passed alongside the input rather than
+     * in it, so the replica stays identical to the CIB and the scheduler can
+     * apply them to its own copy.
+     */
+    crm_xml_add(cmd, XML_ATTR_DC_UUID, fsa_our_uuid);
+    crm_xml_add_int(cmd, XML_ATTR_HAVE_QUORUM, fsa_has_quorum);
+    crm_xml_add(cmd, XML_ATTR_HAVE_WATCHDOG, watchdog?"true":"false");
 
     if (ever_had_quorum && crm_have_quorum == FALSE) {
-        crm_xml_add_int(output, XML_ATTR_QUORUM_PANIC, 1);
+        crm_xml_add_int(cmd, XML_ATTR_QUORUM_PANIC, 1);
     }
 
-    cmd = create_request(CRM_OP_PECALC, output, NULL, CRM_SYSTEM_PENGINE, CRM_SYSTEM_DC, NULL);
-
     rc = pe_subsystem_send(cmd);
     if (rc < 0) {
         crm_err("Could not contact the scheduler: %s " CRM_XS " rc=%d",
                 pcmk_strerror(rc), rc);
+        forget_sched_input();
         register_fsa_error_adv(C_FSA_INTERNAL, I_ERROR, NULL, NULL, __FUNCTION__);
     } else {
+        // The scheduler now has everything up to this point
+        g_list_free_full(sched_patches, (GDestroyNotify) free_xml);
+        sched_patches = NULL;
+        sched_npatches = 0;
+        sched_has_base = TRUE;
+
         controld_expect_sched_reply(cmd);
         crm_debug("Invoking the scheduler: query=%d, ref=%s, seq=%llu, quorate=%d",
                   fsa_pe_query, fsa_pe_ref, crm_peer_seq, fsa_has_quorum);
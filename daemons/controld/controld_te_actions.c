@@ -558,6 +558,7 @@ te_action_confirmed(crm_action_t *action, crm_graph_t *graph)
             && (crm_element_value(action->xml, XML_LRM_ATTR_TARGET) != NULL)) {
             te_update_job_count(action, -1);
         }
+        controld_metrics_action_confirmed(action);
         action->confirmed = TRUE;
     }
     if (graph) {
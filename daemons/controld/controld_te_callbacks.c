@@ -377,6 +377,63 @@ process_op_deletion(const char *xpath, xmlNode *change)
     free(node_uuid);
 }
 
+/*!
+ * \internal
+ * \brief Check whether XML sets only node attributes unused by transition
+ *
+ * \param[in]  xml    Created or modified transient attribute XML
+ * \param[out] count  Incremented for each node attribute found
+ *
+ * \return TRUE if no node attribute in \p xml is used, FALSE otherwise
+ */
+static bool
+attrs_unused(xmlNode *xml, int *count)
+{
+    if (safe_str_eq((const char *) xml->name, XML_CIB_TAG_NVPAIR)) {
+        const char *name = crm_element_value(xml, XML_NVPAIR_ATTR_NAME);
+
+        (*count)++;
+        return (name != NULL)
+               && (g_hash_table_lookup(transition_graph->unused_attrs,
+                                       name) != NULL);
+    }
+    for (xmlNode *child = __xml_first_child_element(xml); child != NULL;
+         child = __xml_next_element(child)) {
+        if (!attrs_unused(child, count)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*!
+ * \internal
+ * \brief Check whether a transient attribute change can be ignored
+ *
+ * The scheduler lists the node attributes that neither the configuration nor
+ * the scheduler itself refers to, so changes to them cannot affect the
+ * current transition (or the next one).
+ *
+ * \param[in] match  Created or modified XML from the change (or NULL)
+ *
+ * \return TRUE if the current transition is unaffected, FALSE otherwise
+ */
+static bool
+transient_change_unused(xmlNode *match)
+{
+    int count = 0;
+
+    /* While the scheduler is being invoked, its input may predate this change,
+     * and the current graph's list may not reflect the latest configuration.
+     */
+    if ((match == NULL) || (transition_graph == NULL)
+        || (transition_graph->unused_attrs == NULL)
+        || ((fsa_state != S_TRANSITION_ENGINE) && (fsa_state != S_IDLE))) {
+        return FALSE;
+    }
+    return attrs_unused(match, &count) && (count > 0);
+}
+
 static void
 process_delete_diff(const char *xpath, const char *op, xmlNode *change)
 {
@@ -497,6 +554,11 @@ te_update_diff_v2(xmlNode *diff)
 
         } else if (strstr(xpath, "/" XML_TAG_TRANSIENT_NODEATTRS "[")
                    || safe_str_eq(name, XML_TAG_TRANSIENT_NODEATTRS)) {
+            if (transient_change_unused(match)) {
+                crm_debug("Transition %d does not depend on %s at %s",
+                          transition_graph->id, name, xpath);
+                continue;
+            }
             abort_unless_down(xpath, op, change, "Transient attribute change");
             break; // Won't be packaged with operation results we may be waiting for
 
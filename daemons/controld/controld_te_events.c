@@ -199,56 +199,30 @@ update_failcount(xmlNode * event, const char *event_node_uuid, int rc,
 crm_action_t *
 controld_get_action(int id)
 {
-    for (GList *item = transition_graph->synapses; item; item = item->next) {
-        synapse_t *synapse = (synapse_t *) item->data;
-
-        for (GList *item2 = synapse->actions; item2; item2 = item2->next) {
-            crm_action_t *action = (crm_action_t *) item2->data;
-
-            if (action->id == id) {
-                return action;
-            }
-        }
-    }
-    return NULL;
+    return g_hash_table_lookup(transition_graph->action_index,
+                               GINT_TO_POINTER(id));
 }
 
 crm_action_t *
 get_cancel_action(const char *id, const char *node)
 {
-    GListPtr gIter = NULL;
-    GListPtr gIter2 = NULL;
-
-    gIter = transition_graph->synapses;
-    for (; gIter != NULL; gIter = gIter->next) {
-        synapse_t *synapse = (synapse_t *) gIter->data;
-
-        gIter2 = synapse->actions;
-        for (; gIter2 != NULL; gIter2 = gIter2->next) {
-            const char *task = NULL;
-            const char *target = NULL;
-            crm_action_t *action = (crm_action_t *) gIter2->data;
-
-            task = crm_element_value(action->xml, XML_LRM_ATTR_TASK);
-            if (safe_str_neq(CRMD_ACTION_CANCEL, task)) {
-                continue;
-            }
+    GList *cancels = NULL;
 
-            task = crm_element_value(action->xml, XML_LRM_ATTR_TASK_KEY);
-            if (safe_str_neq(task, id)) {
-                crm_trace("Wrong key %s for %s on %s", task, id, node);
-                continue;
-            }
+    CRM_CHECK(id != NULL, return NULL);
 
-            target = crm_element_value(action->xml, XML_LRM_ATTR_TARGET_UUID);
-            if (node && safe_str_neq(target, node)) {
-                crm_trace("Wrong node %s for %s on %s", target, id, node);
-                continue;
-            }
+    cancels = g_hash_table_lookup(transition_graph->cancel_index, id);
+    for (GList *iter = cancels; iter != NULL; iter = iter->next) {
+        crm_action_t *action = (crm_action_t *) iter->data;
+        const char *target = NULL;
 
-            crm_trace("Found %s on %s", id, node);
-            return action;
+        target = crm_element_value(action->xml, XML_LRM_ATTR_TARGET_UUID);
+        if (node && safe_str_neq(target, node)) {
+            crm_trace("Wrong node %s for %s on %s", target, id, node);
+            continue;
         }
+
+        crm_trace("Found %s on %s", id, node);
+        return action;
     }
 
     return NULL;
@@ -328,6 +302,36 @@ match_down_event(const char *target)
     return match;
 }
 
+/*!
+ * \internal
+ * \brief Feed an action result's timing into its node's job limit
+ *
+ * \param[in] action  Graph action that result is for
+ * \param[in] event   Action result from resource history
+ */
+static void
+record_action_latency(crm_action_t *action, xmlNode *event)
+{
+    guint queue_ms = 0;
+    guint exec_ms = 0;
+
+    // Job limits apply to the cluster node hosting any remote connection
+    const char *target = crm_element_value(action->xml,
+                                           XML_LRM_ATTR_ROUTER_NODE);
+
+    if (target == NULL) {
+        target = crm_element_value(action->xml, XML_LRM_ATTR_TARGET);
+    }
+    if ((action->type != action_type_rsc) || (target == NULL)
+        || (crm_element_value_ms(event, XML_RSC_OP_T_QUEUE,
+                                 &queue_ms) != pcmk_ok)
+        || (crm_element_value_ms(event, XML_RSC_OP_T_EXEC,
+                                 &exec_ms) != pcmk_ok)) {
+        return;
+    }
+    throttle_record_latency(target, queue_ms, exec_ms);
+}
+
 void
 process_graph_event(xmlNode *event, const char *event_node)
 {
@@ -446,6 +450,7 @@ process_graph_event(xmlNode *event, const char *event_node)
             }
 
             stop_te_timer(action->timer);
+            record_action_latency(action, event);
             te_action_confirmed(action, transition_graph);
 
             if (action->failed) {
@@ -165,6 +165,7 @@ abort_transition_graph(int abort_priority, enum transition_action abort_action,
 
     abort_timer.aborted = TRUE;
     controld_expect_sched_reply(NULL);
+    controld_metrics_abort(abort_text);
 
     if (transition_graph->complete == FALSE) {
         if(update_abort_priority(transition_graph, abort_priority, abort_action, abort_text)) {
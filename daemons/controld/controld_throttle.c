@@ -37,6 +37,16 @@ struct throttle_record_s {
     int max;
     enum throttle_state_e mode;
     char *node;
+
+    /* Latency-driven limit, adjusted additively up and multiplicatively down
+     * according to the queue and execution times of action results
+     */
+    int adaptive;               // Current limit (0 if no results yet)
+    int credit;                 // Uncongested results since last increase
+    time_t last_decrease;       // When adaptive limit was last lowered
+    guint queue_ms;             // Queue time of most recent result
+    guint exec_ms;              // Execution time of most recent result
+    unsigned int decreases;     // Number of times adaptive limit was lowered
 };
 
 static int throttle_job_max = 0;
@@ -46,6 +56,14 @@ static float throttle_load_target = 0.0;
 #define THROTTLE_FACTOR_MEDIUM 1.6
 #define THROTTLE_FACTOR_HIGH   2.0
 
+/* A result is considered congested if it waited in the executor's queue longer
+ * than both this and its own execution time.
+ */
+#define THROTTLE_QUEUE_MIN_MS       1000
+
+// Lower the adaptive limit at most once per this many seconds
+#define THROTTLE_DECREASE_INTERVAL  5
+
 static GHashTable *throttle_records = NULL;
 static mainloop_timer_t *throttle_timer = NULL;
 
@@ -489,13 +507,19 @@ throttle_get_total_job_limit(int l)
     return limit;
 }
 
-int
-throttle_get_job_limit(const char *node)
+/*!
+ * \internal
+ * \brief Find or create the throttle record for a node
+ *
+ * \param[in] node  Name of node
+ *
+ * \return Throttle record for \p node
+ */
+static struct throttle_record_s *
+throttle_record(const char *node)
 {
-    int jobs = 1;
-    struct throttle_record_s *r = NULL;
+    struct throttle_record_s *r = g_hash_table_lookup(throttle_records, node);
 
-    r = g_hash_table_lookup(throttle_records, node);
     if(r == NULL) {
         r = calloc(1, sizeof(struct throttle_record_s));
         r->node = strdup(node);
@@ -505,6 +529,21 @@ throttle_get_job_limit(const char *node)
 
         g_hash_table_insert(throttle_records, r->node, r);
     }
+    return r;
+}
+
+/*!
+ * \internal
+ * \brief Get the job limit for a node based on its reported load alone
+ *
+ * \param[in] r  Throttle record for node
+ *
+ * \return Maximum number of jobs allowed by node's load
+ */
+static int
+throttle_load_job_limit(struct throttle_record_s *r)
+{
+    int jobs = 1;
 
     switch(r->mode) {
         case throttle_extreme:
@@ -521,12 +560,108 @@ throttle_get_job_limit(const char *node)
             jobs = QB_MAX(1, r->max);
             break;
         default:
-            crm_err("Unknown throttle mode %.4x on %s", r->mode, node);
+            crm_err("Unknown throttle mode %.4x on %s", r->mode, r->node);
             break;
     }
     return jobs;
 }
 
+int
+throttle_get_job_limit(const char *node)
+{
+    struct throttle_record_s *r = throttle_record(node);
+    int jobs = throttle_load_job_limit(r);
+
+    if ((r->adaptive > 0) && (r->adaptive < jobs)) {
+        jobs = r->adaptive;
+    }
+    return jobs;
+}
+
+/*!
+ * \internal
+ * \brief Adjust a node's job limit based on the timing of an action result
+ *
+ * \param[in] node      Node that executed action (or hosts its connection)
+ * \param[in] queue_ms  How long action waited in the executor's queue
+ * \param[in] exec_ms   How long action took to execute
+ */
+void
+throttle_record_latency(const char *node, guint queue_ms, guint exec_ms)
+{
+    struct throttle_record_s *r = NULL;
+    int ceiling = 0;
+
+    if ((node == NULL) || (throttle_records == NULL)) {
+        return;
+    }
+
+    r = throttle_record(node);
+    r->queue_ms = queue_ms;
+    r->exec_ms = exec_ms;
+
+    ceiling = QB_MAX(1, r->max);
+    if (r->adaptive <= 0) {
+        r->adaptive = throttle_load_job_limit(r);
+    } else if (r->adaptive > ceiling) {
+        r->adaptive = ceiling;
+    }
+
+    if ((queue_ms > THROTTLE_QUEUE_MIN_MS) && (queue_ms > exec_ms)) {
+        time_t now = time(NULL);
+
+        r->credit = 0;
+        if ((r->adaptive > 1)
+            && ((now - r->last_decrease) >= THROTTLE_DECREASE_INTERVAL)) {
+            r->adaptive = QB_MAX(1, r->adaptive / 2);
+            r->last_decrease = now;
+            r->decreases++;
+            crm_info("Lowering job limit for %s to %d because actions are "
+                     "queuing " CRM_XS " queue-time=%ums exec-time=%ums",
+                     node, r->adaptive, queue_ms, exec_ms);
+        }
+
+    } else if ((r->adaptive < ceiling) && (++(r->credit) >= r->adaptive)) {
+        // Raise the limit by one for each limit's worth of timely results
+        r->credit = 0;
+        r->adaptive++;
+        crm_debug("Raising job limit for %s to %d", node, r->adaptive);
+    }
+}
+
+/*!
+ * \internal
+ * \brief Create XML describing the job limits of all known nodes
+ *
+ * \return Newly allocated XML
+ */
+xmlNode *
+throttle_job_limits_xml(void)
+{
+    xmlNode *xml = create_xml_node(NULL, PCMK__XE_JOB_LIMITS);
+    GHashTableIter iter;
+    struct throttle_record_s *r = NULL;
+
+    if (throttle_records == NULL) {
+        return xml;
+    }
+
+    g_hash_table_iter_init(&iter, throttle_records);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &r)) {
+        xmlNode *node = create_xml_node(xml, XML_CIB_TAG_NODE);
+
+        crm_xml_add(node, XML_ATTR_UNAME, r->node);
+        crm_xml_add_int(node, PCMK__XA_JOB_LIMIT, throttle_get_job_limit(r->node));
+        crm_xml_add_int(node, PCMK__XA_JOB_MAX, r->max);
+        crm_xml_add(node, PCMK__XA_LOAD, load2str(r->mode));
+        crm_xml_add_int(node, PCMK__XA_ADAPTIVE_LIMIT, r->adaptive);
+        crm_xml_add_int(node, PCMK__XA_LIMIT_DECREASES, r->decreases);
+        crm_xml_add_ms(node, XML_RSC_OP_T_QUEUE, r->queue_ms);
+        crm_xml_add_ms(node, XML_RSC_OP_T_EXEC, r->exec_ms);
+    }
+    return xml;
+}
+
 void
 throttle_update(xmlNode *xml)
 {
@@ -548,6 +683,9 @@ throttle_update(xmlNode *xml)
 
     r->max = max;
     r->mode = (enum throttle_state_e) mode;
+    if (r->adaptive > QB_MAX(1, max)) {
+        r->adaptive = QB_MAX(1, max);
+    }
 
     crm_debug("Node %s has %s load and supports at most %d jobs; new job limit %d",
               from, load2str((enum throttle_state_e) mode), max,
@@ -25,3 +25,5 @@ void throttle_update(xmlNode *xml);
 void throttle_update_job_max(const char *preference);
 int throttle_get_job_limit(const char *node);
 int throttle_get_total_job_limit(int l);
+void throttle_record_latency(const char *node, guint queue_ms, guint exec_ms);
+xmlNode *throttle_job_limits_xml(void);
@@ -20,6 +20,7 @@ extern crm_graph_functions_t te_graph_fns;
 static void
 global_cib_callback(const xmlNode * msg, int callid, int rc, xmlNode * output)
 {
+    controld_sched_cib_op_done();
 }
 
 static crm_graph_t *
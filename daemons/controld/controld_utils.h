@@ -61,6 +61,10 @@ void pe_subsystem_free(void);
 void controld_stop_sched_timer(void);
 void controld_free_sched_timer(void);
 void controld_expect_sched_reply(xmlNode *msg);
+void controld_sched_cib_updated(xmlNode *msg);
+void controld_sched_cib_replaced(void);
+void controld_sched_need_full_input(void);
+void controld_sched_cib_op_done(void);
 
 void fsa_dump_actions(long long action, const char *text);
 void fsa_dump_inputs(int log_level, const char *text, long long input_register);
@@ -98,8 +102,11 @@ enum controld_section_e {
 
 void controld_delete_node_state(const char *uname,
                                 enum controld_section_e section, int options);
+void controld_delete_node_history_except(const char *uname, xmlNode *keep,
+                                         int options);
 int controld_delete_resource_history(const char *rsc_id, const char *node,
                                      const char *user_name, int call_options);
+void controld_flush_resource_updates(void);
 
 const char *get_node_id(xmlNode *lrm_rsc_op);
 
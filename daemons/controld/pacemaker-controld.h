@@ -19,6 +19,7 @@
 #include <controld_membership.h>
 #include <controld_messages.h>
 #include <controld_metadata.h>
+#include <controld_metrics.h>
 #include <controld_throttle.h>
 #include <controld_transition.h>
 #include <controld_utils.h>
@@ -20,6 +20,7 @@
 #endif
 
 #include <unistd.h>
+#include <limits.h>
 
 #include <crm/crm.h>
 #include <crm/services.h>
@@ -96,12 +97,59 @@ typedef struct lrmd_cmd_s {
     int last_notify_op_status;
     int last_pid;
 
+    gboolean holds_slot;    // Counts against the executor-wide action limit
+    unsigned int unchanged; // Results suppressed since last notification
+    unsigned int params_gen;    // Value of signon_count when params last sent
+
     GHashTable *params;
 } lrmd_cmd_t;
 
 static void cmd_finalize(lrmd_cmd_t * cmd, lrmd_rsc_t * rsc);
 static gboolean lrmd_rsc_dispatch(gpointer user_data);
 static void cancel_all_recurring(lrmd_rsc_t * rsc, const char *client_id);
+static void release_slot(lrmd_cmd_t *cmd);
+
+/* Operations are normally run as soon as their resource is idle. If an
+ * executor-wide limit on running operations is configured, resources whose
+ * next operation has to wait are queued by the priority class of that
+ * operation, and are given execution slots in class order (first come first
+ * served within a class, which keeps things fair across resources).
+ */
+enum execd_op_class {
+    execd_class_stop = 0,   // stop, demote
+    execd_class_start,      // start, promote, and anything else
+    execd_class_probe,      // non-recurring monitor
+    execd_class_monitor,    // first run of recurring monitor
+    execd_class_count
+};
+
+static const char *execd_class_names[execd_class_count] = {
+    "stop", "start", "probe", "monitor"
+};
+
+static int action_limit = 0;    // Maximum operations at once (0 for no limit)
+static int active_count = 0;    // Running operations plus reserved slots
+static GQueue run_queue[execd_class_count];
+
+/* Recurring results not sent to clients because they were unchanged, since
+ * this was last logged (as a sign of life for otherwise silent monitors)
+ */
+static unsigned int unchanged_results = 0;
+static guint unchanged_timer = 0;
+
+#define EXECD_LIVENESS_INTERVAL_S 900
+
+/* Number of client sign-ons, so parameters are sent again to clients that
+ * connected after they were last sent
+ */
+static unsigned int signon_count = 0;
+
+// Queue time statistics per class since they were last logged
+static struct {
+    unsigned int waited;
+    long long total_ms;
+    int max_ms;
+} queue_stats[execd_class_count];
 
 #ifdef PCMK__TIME_USE_CGT
 
@@ -494,25 +542,11 @@ create_lrmd_reply(const char *origin, int rc, int call_id)
 }
 
 static void
-send_client_notify(gpointer key, gpointer value, gpointer user_data)
+log_notify_failure(pcmk__client_t *client, int rc)
 {
-    xmlNode *update_msg = user_data;
-    pcmk__client_t *client = value;
-    int rc;
     int log_level = LOG_WARNING;
     const char *msg = NULL;
 
-    CRM_CHECK(client != NULL, return);
-    if (client->name == NULL) {
-        crm_trace("Skipping notification to client without name");
-        return;
-    }
-
-    rc = lrmd_server_send_notify(client, update_msg);
-    if (rc == pcmk_rc_ok) {
-        return;
-    }
-
     switch (rc) {
         case ENOTCONN:
         case EPIPE: // Client exited without waiting for notification
@@ -529,10 +563,108 @@ send_client_notify(gpointer key, gpointer value, gpointer user_data)
                client->name, client->id, msg, rc);
 }
 
+static void
+send_client_notify(gpointer key, gpointer value, gpointer user_data)
+{
+    xmlNode *update_msg = user_data;
+    pcmk__client_t *client = value;
+    int rc;
+
+    CRM_CHECK(client != NULL, return);
+    if (client->name == NULL) {
+        crm_trace("Skipping notification to client without name");
+        return;
+    }
+
+    rc = lrmd_server_send_notify(client, update_msg);
+    if (rc != pcmk_rc_ok) {
+        log_notify_failure(client, rc);
+    }
+}
+
+struct notify_all_data {
+    xmlNode *msg;
+    pcmk__ipc_shared_event_t *event; // Serialized once for all IPC clients
+};
+
+static void
+send_shared_notify(gpointer key, gpointer value, gpointer user_data)
+{
+    struct notify_all_data *data = user_data;
+    pcmk__client_t *client = value;
+    int rc;
+
+    CRM_CHECK(client != NULL, return);
+    if (client->name == NULL) {
+        crm_trace("Skipping notification to client without name");
+        return;
+    }
+
+    if ((data->event != NULL) && (client->kind == PCMK__CLIENT_IPC)
+        && (client->ipcs != NULL)) {
+        rc = pcmk__ipc_send_shared_event(client, data->event,
+                                         crm_ipc_server_event);
+    } else {
+        rc = lrmd_server_send_notify(client, data->msg);
+    }
+    if (rc != pcmk_rc_ok) {
+        log_notify_failure(client, rc);
+    }
+}
+
+/*!
+ * \internal
+ * \brief Send a notification to all clients
+ *
+ * \param[in] notify  Notification XML to send
+ *
+ * \note The notification is serialized once and shared by all IPC clients'
+ *       event queues, rather than copied for each client.
+ */
+static void
+notify_all_clients(xmlNode *notify)
+{
+    struct notify_all_data data = { notify, NULL };
+
+    if (pcmk__ipc_client_count() > 1) {
+        int rc = pcmk__ipc_new_shared_event(notify, &(data.event));
+
+        if (rc != pcmk_rc_ok) {
+            // Fall back to serializing per client
+            crm_debug("Could not prepare shared notification: %s "
+                      CRM_XS " rc=%d", pcmk_rc_str(rc), rc);
+        }
+    }
+    pcmk__foreach_ipc_client(send_shared_notify, &data);
+    pcmk__ipc_free_shared_event(data.event);
+}
+
+static gboolean
+log_unchanged_results(gpointer user_data)
+{
+    crm_info("%u recurring operation result%s unchanged in the last %d minutes",
+             unchanged_results, pcmk__plural_s(unchanged_results),
+             EXECD_LIVENESS_INTERVAL_S / 60);
+    unchanged_results = 0;
+    unchanged_timer = 0;
+    return FALSE;
+}
+
+static void
+count_unchanged_result(void)
+{
+    unchanged_results++;
+    if (unchanged_timer == 0) {
+        unchanged_timer = g_timeout_add_seconds(EXECD_LIVENESS_INTERVAL_S,
+                                                log_unchanged_results, NULL);
+    }
+}
+
 static void
 send_cmd_complete_notify(lrmd_cmd_t * cmd)
 {
     xmlNode *notify = NULL;
+    bool send_params = TRUE;
 
 #ifdef PCMK__TIME_USE_CGT
     int exec_time = time_diff_ms(NULL, &(cmd->t_run));
@@ -551,11 +683,23 @@ send_cmd_complete_notify(lrmd_cmd_t * cmd)
             cmd->last_notify_op_status == cmd->lrmd_op_status) {
 
             /* only send changes */
+            cmd->unchanged++;
+            count_unchanged_result();
             return;
         }
 
     }
 
+    if (cmd->unchanged > 0) {
+        crm_debug("%s %s result changed after %u unchanged result%s",
+                  cmd->rsc_id, cmd->action, cmd->unchanged,
+                  pcmk__plural_s(cmd->unchanged));
+        cmd->unchanged = 0;
+    }
+
+    send_params = !cmd->first_notify_sent
+                  || !(cmd->call_opts & lrmd_opt_notify_params_once)
+                  || (cmd->params_gen != signon_count);
     cmd->first_notify_sent = 1;
     cmd->last_notify_rc = cmd->exec_rc;
     cmd->last_notify_op_status = cmd->lrmd_op_status;
@@ -591,13 +735,18 @@ send_cmd_complete_notify(lrmd_cmd_t * cmd)
     crm_xml_add(notify, F_LRMD_RSC_OUTPUT, cmd->output);
     crm_xml_add(notify, F_LRMD_RSC_EXIT_REASON, cmd->exit_reason);
 
-    if (cmd->params) {
+    /* The parameters of a recurring operation can't change, so a client that
+     * remembers them doesn't need them again
+     */
+    if (cmd->params && send_params) {
         char *key = NULL;
         char *value = NULL;
         GHashTableIter iter;
 
         xmlNode *args = create_xml_node(notify, XML_TAG_ATTRS);
 
+        cmd->params_gen = signon_count;
+
         g_hash_table_iter_init(&iter, cmd->params);
         while (g_hash_table_iter_next(&iter, (gpointer *) & key, (gpointer *) & value)) {
             hash2smartfield((gpointer) key, (gpointer) value, args);
@@ -610,7 +759,7 @@ send_cmd_complete_notify(lrmd_cmd_t * cmd)
             send_client_notify(client->id, client, notify);
         }
     } else {
-        pcmk__foreach_ipc_client(send_client_notify, notify);
+        notify_all_clients(notify);
     }
 
     free_xml(notify);
@@ -635,7 +784,7 @@ send_generic_notify(int rc, xmlNode * request)
         crm_xml_add(notify, F_LRMD_OPERATION, op);
         crm_xml_add(notify, F_LRMD_RSC_ID, rsc_id);
 
-        pcmk__foreach_ipc_client(send_client_notify, notify);
+        notify_all_clients(notify);
 
         free_xml(notify);
     }
@@ -663,6 +812,8 @@ cmd_finalize(lrmd_cmd_t * cmd, lrmd_rsc_t * rsc)
     crm_trace("Resource operation rsc:%s action:%s completed (%p %p)", cmd->rsc_id, cmd->action,
               rsc ? rsc->active : NULL, cmd);
 
+    release_slot(cmd);
+
     if (rsc && (rsc->active == cmd)) {
         rsc->active = NULL;
         mainloop_set_trigger(rsc->work);
@@ -1003,6 +1154,10 @@ action_complete(svc_action_t * action)
                            cmd->rsc_id, cmd->action, services_ocf_exitcode_str(cmd->exec_rc), cmd->exec_rc, time_sum, timeout_left, delay);
             }
 
+            /* Give up the execution slot while waiting to re-poll; the command
+             * will get a new one when it is dispatched again.
+             */
+            release_slot(cmd);
             cmd_reset(cmd);
             if(rsc) {
                 rsc->active = NULL;
@@ -1377,6 +1532,185 @@ lrmd_rsc_execute_service_lib(lrmd_rsc_t * rsc, lrmd_cmd_t * cmd)
     return TRUE;
 }
 
+/*!
+ * \internal
+ * \brief Read the executor-wide action limit from the environment
+ */
+void
+execd_scheduler_init(void)
+{
+    const char *limit_s = pcmk__env_option("execd_action_limit");
+
+    if (limit_s != NULL) {
+        long long limit = crm_parse_ll(limit_s, NULL);
+
+        if (limit > 0) {
+            action_limit = (int) QB_MIN(limit, INT_MAX);
+            crm_info("Running at most %d operations at once", action_limit);
+        } else if (limit < 0) {
+            crm_warn("Ignoring invalid execd action limit '%s'", limit_s);
+        }
+    }
+}
+
+static enum execd_op_class
+cmd_class(const lrmd_cmd_t *cmd)
+{
+    if (safe_str_eq(cmd->action, "stop")
+        || safe_str_eq(cmd->action, "demote")) {
+        return execd_class_stop;
+    }
+    if (safe_str_eq(cmd->action, "monitor")) {
+        return cmd->interval_ms? execd_class_monitor : execd_class_probe;
+    }
+    return execd_class_start;
+}
+
+static void
+log_queue_stats(void)
+{
+    for (int c = 0; c < execd_class_count; c++) {
+        if (queue_stats[c].waited > 0) {
+            crm_info("%u %s operation%s waited for an execution slot "
+                     "(average %lldms, maximum %dms)",
+                     queue_stats[c].waited, execd_class_names[c],
+                     pcmk__plural_s(queue_stats[c].waited),
+                     queue_stats[c].total_ms / queue_stats[c].waited,
+                     queue_stats[c].max_ms);
+        }
+    }
+    memset(queue_stats, 0, sizeof(queue_stats));
+}
+
+/*!
+ * \internal
+ * \brief Give free execution slots to queued resources in priority order
+ */
+static void
+run_queued_rscs(void)
+{
+    bool drained = TRUE;
+
+    while ((action_limit <= 0) || (active_count < action_limit)) {
+        lrmd_rsc_t *rsc = NULL;
+
+        for (int c = 0; (rsc == NULL) && (c < execd_class_count); c++) {
+            rsc = g_queue_pop_head(&run_queue[c]);
+        }
+        if (rsc == NULL) {
+            break;
+        }
+        rsc->queued = FALSE;
+        rsc->granted = TRUE;
+        active_count++;
+        mainloop_set_trigger(rsc->work);
+    }
+
+    for (int c = 0; c < execd_class_count; c++) {
+        if (!g_queue_is_empty(&run_queue[c])) {
+            drained = FALSE;
+        }
+    }
+    if (drained) {
+        log_queue_stats();
+    }
+}
+
+static void
+release_slot(lrmd_cmd_t *cmd)
+{
+    if (cmd->holds_slot) {
+        cmd->holds_slot = FALSE;
+        active_count--;
+        run_queued_rscs();
+    }
+}
+
+static void
+release_reservation(lrmd_rsc_t *rsc)
+{
+    if (rsc->queued) {
+        for (int c = 0; c < execd_class_count; c++) {
+            g_queue_remove(&run_queue[c], rsc);
+        }
+        rsc->queued = FALSE;
+    }
+    if (rsc->granted) {
+        rsc->granted = FALSE;
+        active_count--;
+        run_queued_rscs();
+    }
+}
+
+/*!
+ * \internal
+ * \brief Get an execution slot for a resource's next operation
+ *
+ * \param[in,out] rsc  Resource with operation to run
+ * \param[in,out] cmd  Operation to run
+ *
+ * \return TRUE if \p cmd may run now, FALSE if \p rsc has been queued
+ */
+static gboolean
+acquire_slot(lrmd_rsc_t *rsc, lrmd_cmd_t *cmd)
+{
+    enum execd_op_class op_class = cmd_class(cmd);
+
+    // Fencing devices are run by the fencer, not by us
+    if (safe_str_eq(rsc->class, PCMK_RESOURCE_CLASS_STONITH)) {
+        return TRUE;
+    }
+
+    // Never count the same operation against the limit twice
+    if (cmd->holds_slot) {
+        return TRUE;
+    }
+
+    if (rsc->granted) {
+        rsc->granted = FALSE;
+#ifdef PCMK__TIME_USE_CGT
+        {
+            int wait_ms = time_diff_ms(NULL, &(cmd->t_queue));
+
+            queue_stats[op_class].waited++;
+            queue_stats[op_class].total_ms += wait_ms;
+            queue_stats[op_class].max_ms = QB_MAX(queue_stats[op_class].max_ms,
+                                                  wait_ms);
+        }
+#else
+        queue_stats[op_class].waited++;
+#endif
+        cmd->holds_slot = TRUE;
+        return TRUE;
+    }
+
+    if (rsc->queued) {
+        return FALSE;
+    }
+
+    if ((action_limit <= 0) || (active_count < action_limit)) {
+        bool ahead = FALSE;
+
+        // Don't jump ahead of anything queued with the same or higher priority
+        for (int c = 0; c <= op_class; c++) {
+            if (!g_queue_is_empty(&run_queue[c])) {
+                ahead = TRUE;
+            }
+        }
+        if (!ahead) {
+            active_count++;
+            cmd->holds_slot = TRUE;
+            return TRUE;
+        }
+    }
+
+    crm_trace("Queueing %s %s: %d of %d execution slots in use",
+              cmd->rsc_id, cmd->action, active_count, action_limit);
+    g_queue_push_tail(&run_queue[op_class], rsc);
+    rsc->queued = TRUE;
+    return FALSE;
+}
+
 static gboolean
 lrmd_rsc_execute(lrmd_rsc_t * rsc)
 {
@@ -1397,6 +1731,10 @@ lrmd_rsc_execute(lrmd_rsc_t * rsc)
             crm_trace
                 ("Command %s %s was asked to run too early, waiting for start_delay timeout of %dms",
                  cmd->rsc_id, cmd->action, cmd->start_delay);
+            release_reservation(rsc);
+            return TRUE;
+        }
+        if (!acquire_slot(rsc, cmd)) {
             return TRUE;
         }
         rsc->pending_ops = g_list_remove_link(rsc->pending_ops, first);
@@ -1410,6 +1748,7 @@ lrmd_rsc_execute(lrmd_rsc_t * rsc)
 
     if (!cmd) {
         crm_trace("Nothing further to do for %s", rsc->rsc_id);
+        release_reservation(rsc);
         return TRUE;
     }
 
@@ -1489,6 +1828,7 @@ free_rsc(gpointer data)
     free(rsc->class);
     free(rsc->provider);
     free(rsc->type);
+    release_reservation(rsc);
     mainloop_destroy_trigger(rsc->work);
 
     free(rsc);
@@ -1508,6 +1848,8 @@ process_lrmd_signon(pcmk__client_t *client, xmlNode *request, int call_id)
         rc = -EPROTO;
     }
 
+    signon_count++;
+
     reply = create_lrmd_reply(__FUNCTION__, rc, call_id);
     crm_xml_add(reply, F_LRMD_OPERATION, CRM_OP_REGISTER);
     crm_xml_add(reply, F_LRMD_CLIENTID, client->id);
@@ -493,6 +493,7 @@ main(int argc, char **argv, char **envp)
     crm_build_path(CRM_RSCTMP_DIR, 0755);
 
     rsc_list = g_hash_table_new_full(crm_str_hash, g_str_equal, NULL, free_rsc);
+    execd_scheduler_init();
     ipcs = mainloop_add_ipc_server(CRM_SYSTEM_LRMD, QB_IPC_SHM, &lrmd_ipc_callbacks);
     if (ipcs == NULL) {
         crm_err("Failed to create IPC server: shutting down and inhibiting respawn");
@@ -45,6 +45,9 @@ typedef struct lrmd_rsc_s {
     int st_probe_rc; // What value should be returned for a probe if stonith
 
     crm_trigger_t *work;
+
+    gboolean queued;    // Waiting in run queue for an execution slot
+    gboolean granted;   // Execution slot reserved for next pending op
 } lrmd_rsc_t;
 
 #  ifdef HAVE_GNUTLS_GNUTLS_H
@@ -64,6 +67,8 @@ void process_lrmd_message(pcmk__client_t *client, uint32_t id,
 
 void free_rsc(gpointer data);
 
+void execd_scheduler_init(void);
+
 void handle_shutdown_ack(void);
 
 void handle_shutdown_nack(void);
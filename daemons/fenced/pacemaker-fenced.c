@@ -282,11 +282,17 @@ get_stonith_flag(const char *name)
     return st_callback_unknown;
 }
 
+struct stonith_notification_s {
+    xmlNode *msg;
+    pcmk__ipc_shared_event_t *event; // Serialized once, on first use
+};
+
 static void
 stonith_notify_client(gpointer key, gpointer value, gpointer user_data)
 {
 
-    xmlNode *update_msg = user_data;
+    struct stonith_notification_s *update = user_data;
+    xmlNode *update_msg = update->msg;
     pcmk__client_t *client = value;
     const char *type = NULL;
 
@@ -302,8 +308,15 @@ stonith_notify_client(gpointer key, gpointer value, gpointer user_data)
     }
 
     if (client->options & get_stonith_flag(type)) {
-        int rc = pcmk__ipc_send_xml(client, 0, update_msg,
-                                    crm_ipc_server_event|crm_ipc_server_error);
+        int rc = pcmk_rc_ok;
+
+        if (update->event == NULL) {
+            rc = pcmk__ipc_new_shared_event(update_msg, &(update->event));
+        }
+        if (rc == pcmk_rc_ok) {
+            rc = pcmk__ipc_send_shared_event(client, update->event,
+                                             crm_ipc_server_error);
+        }
 
         if (rc != pcmk_rc_ok) {
             crm_warn("%s notification of client %s failed: %s "
@@ -350,6 +363,7 @@ do_stonith_notify(int options, const char *type, int result, xmlNode * data)
 {
     /* TODO: Standardize the contents of data */
     xmlNode *update_msg = create_xml_node(NULL, "notify");
+    struct stonith_notification_s update = { update_msg, NULL };
 
     CRM_CHECK(type != NULL,;);
 
@@ -363,7 +377,8 @@ do_stonith_notify(int options, const char *type, int result, xmlNode * data)
     }
 
     crm_trace("Notifying clients");
-    pcmk__foreach_ipc_client(stonith_notify_client, update_msg);
+    pcmk__foreach_ipc_client(stonith_notify_client, &update);
+    pcmk__ipc_free_shared_event(update.event);
     free_xml(update_msg);
     crm_trace("Notify complete");
 }
@@ -50,6 +50,257 @@ series_t series[] = {
 
 void pengine_shutdown(int nsig);
 
+/*!
+ * \internal
+ * \brief Set a cluster option in scheduler input, overriding any existing value
+ *
+ * \param[in,out] xml         Scheduler input
+ * \param[in]     attr_name   Name of cluster option to set
+ * \param[in]     attr_value  Value to set
+ */
+static void
+force_local_option(xmlNode *xml, const char *attr_name, const char *attr_value)
+{
+    int max = 0;
+    int lpc = 0;
+    char *xpath_string = NULL;
+    xmlXPathObjectPtr xpathObj = NULL;
+
+    xpath_string = crm_strdup_printf("//%s/%s/%s//%s//nvpair[@name='%.128s']",
+                                     XML_TAG_CIB, XML_CIB_TAG_CONFIGURATION,
+                                     XML_CIB_TAG_CRMCONFIG,
+                                     XML_CIB_TAG_PROPSET, attr_name);
+    xpathObj = xpath_search(xml, xpath_string);
+    max = numXpathResults(xpathObj);
+    free(xpath_string);
+
+    for (lpc = 0; lpc < max; lpc++) {
+        xmlNode *match = getXpathResult(xpathObj, lpc);
+        crm_trace("Forcing %s/%s = %s", ID(match), attr_name, attr_value);
+        crm_xml_add(match, XML_NVPAIR_ATTR_VALUE, attr_value);
+    }
+
+    if(max == 0) {
+        xmlNode *configuration = NULL;
+        xmlNode *crm_config = NULL;
+        xmlNode *cluster_property_set = NULL;
+
+        crm_trace("Creating %s-%s for %s=%s",
+                  CIB_OPTIONS_FIRST, attr_name, attr_name, attr_value);
+
+        configuration = find_entity(xml, XML_CIB_TAG_CONFIGURATION, NULL);
+        if (configuration == NULL) {
+            configuration = create_xml_node(xml, XML_CIB_TAG_CONFIGURATION);
+        }
+
+        crm_config = find_entity(configuration, XML_CIB_TAG_CRMCONFIG, NULL);
+        if (crm_config == NULL) {
+            crm_config = create_xml_node(configuration, XML_CIB_TAG_CRMCONFIG);
+        }
+
+        cluster_property_set = find_entity(crm_config, XML_CIB_TAG_PROPSET, NULL);
+        if (cluster_property_set == NULL) {
+            cluster_property_set = create_xml_node(crm_config, XML_CIB_TAG_PROPSET);
+            crm_xml_add(cluster_property_set, XML_ATTR_ID, CIB_OPTIONS_FIRST);
+        }
+
+        xml = create_xml_node(cluster_property_set, XML_CIB_TAG_NVPAIR);
+
+        crm_xml_set_id(xml, "%s-%s", CIB_OPTIONS_FIRST, attr_name);
+        crm_xml_add(xml, XML_NVPAIR_ATTR_NAME, attr_name);
+        crm_xml_add(xml, XML_NVPAIR_ATTR_VALUE, attr_value);
+    }
+    freeXpathObject(xpathObj);
+}
+
+/*!
+ * \internal
+ * \brief Build the CIB to schedule from a controller request
+ *
+ * The controller sends either a full CIB or the patchsets applied since its
+ * previous request, along with values that it supplies itself (such as quorum)
+ * as attributes of the request.
+ *
+ * \param[in] msg       Scheduler request
+ * \param[in] xml_data  Request data (full CIB or patchsets)
+ *
+ * \return Newly allocated scheduler input, or NULL if a full CIB is needed
+ */
+static xmlNode *
+sched_input(xmlNode *msg, xmlNode *xml_data)
+{
+    static xmlNode *last_input = NULL;  // Previous input without overrides
+
+    xmlNode *input = NULL;
+    const char *value = NULL;
+
+    if (xml_data == NULL) {
+        return NULL;
+
+    } else if (crm_str_eq(TYPE(xml_data), PCMK__XE_CIB_PATCHES, TRUE)) {
+        for (xmlNode *patchset = __xml_first_child_element(xml_data);
+             (patchset != NULL) && (last_input != NULL);
+             patchset = __xml_next_element(patchset)) {
+
+            int rc = xml_apply_patchset(last_input, patchset, TRUE);
+
+            if (rc != pcmk_ok) {
+                crm_info("Could not apply CIB patchset to previous input: %s "
+                         CRM_XS " rc=%d", pcmk_strerror(rc), rc);
+                free_xml(last_input);
+                last_input = NULL;
+            }
+        }
+        if (last_input == NULL) {
+            return NULL;
+        }
+
+    } else {
+        free_xml(last_input);
+        last_input = copy_xml(xml_data);
+    }
+
+    input = copy_xml(last_input);
+
+    value = crm_element_value(msg, XML_ATTR_DC_UUID);
+    if (value != NULL) {
+        crm_xml_add(input, XML_ATTR_DC_UUID, value);
+    }
+    value = crm_element_value(msg, XML_ATTR_HAVE_QUORUM);
+    if (value != NULL) {
+        crm_xml_add(input, XML_ATTR_HAVE_QUORUM, value);
+    }
+    value = crm_element_value(msg, XML_ATTR_QUORUM_PANIC);
+    if (value != NULL) {
+        crm_xml_add(input, XML_ATTR_QUORUM_PANIC, value);
+    }
+    value = crm_element_value(msg, XML_ATTR_HAVE_WATCHDOG);
+    if (value != NULL) {
+        force_local_option(input, XML_ATTR_HAVE_WATCHDOG, value);
+    }
+    return input;
+}
+
+/*!
+ * \internal
+ * \brief Check whether the scheduler uses a node attribute regardless of rules
+ *
+ * \param[in] name  Node attribute name
+ *
+ * \return TRUE if \p name has built-in meaning to the scheduler
+ */
+static bool
+node_attr_is_builtin(const char *name)
+{
+    static const char *builtin[] = {
+        XML_CIB_ATTR_SHUTDOWN, "terminate", "standby", "maintenance",
+        XML_NODE_ATTR_RSC_DISCOVERY, CRM_OP_PROBED, "site-name",
+    };
+
+    if ((name[0] == '#') // Includes node health attributes
+        || pcmk__starts_with(name, PCMK__FAIL_COUNT_PREFIX)
+        || pcmk__starts_with(name, PCMK__LAST_FAILURE_PREFIX)
+        || pcmk__starts_with(name, "master-")) {
+        return TRUE;
+    }
+    for (int lpc = 0; lpc < DIMOF(builtin); lpc++) {
+        if (strcmp(name, builtin[lpc]) == 0) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*!
+ * \internal
+ * \brief Add names of node attributes referenced by configuration to a table
+ *
+ * \param[in]     xml    Configuration XML to search
+ * \param[in,out] names  Table to add referenced attribute names to
+ */
+static void
+add_referenced_node_attrs(xmlNode *xml, GHashTable *names)
+{
+    static const char *refs[] = {
+        XML_EXPR_ATTR_ATTRIBUTE, XML_RULE_ATTR_SCORE_ATTRIBUTE,
+        XML_COLOC_ATTR_NODE_ATTR,
+    };
+
+    for (int lpc = 0; lpc < DIMOF(refs); lpc++) {
+        const char *name = crm_element_value(xml, refs[lpc]);
+
+        if (name != NULL) {
+            g_hash_table_insert(names, (gpointer) name, (gpointer) name);
+        }
+    }
+    for (xmlNode *child = __xml_first_child_element(xml); child != NULL;
+         child = __xml_next_element(child)) {
+        add_referenced_node_attrs(child, names);
+    }
+}
+
+/*!
+ * \internal
+ * \brief List node attributes that a transition graph does not depend on
+ *
+ * The controller can then ignore changes to these attributes rather than
+ * abort the transition.
+ *
+ * \param[in,out] data_set  Working set with newly calculated graph
+ */
+static void
+add_unused_node_attrs(pe_working_set_t *data_set)
+{
+    xmlNode *config = NULL;
+    xmlNode *unused = NULL;
+    GHashTable *referenced = NULL;
+    GHashTable *seen = NULL;
+
+    /* Fencing actions are passed all of the target's attributes, so any
+     * attribute change could affect them.
+     */
+    for (GList *iter = data_set->actions; iter != NULL; iter = iter->next) {
+        pe_action_t *action = (pe_action_t *) iter->data;
+
+        if (safe_str_eq(action->task, CRM_OP_FENCE)
+            && is_not_set(action->flags, pe_action_optional)) {
+            return;
+        }
+    }
+
+    referenced = g_hash_table_new(crm_str_hash, g_str_equal);
+    seen = g_hash_table_new(crm_str_hash, g_str_equal);
+    config = first_named_child(data_set->input, XML_CIB_TAG_CONFIGURATION);
+    if (config != NULL) {
+        add_referenced_node_attrs(config, referenced);
+    }
+
+    for (GList *iter = data_set->nodes; iter != NULL; iter = iter->next) {
+        pe_node_t *node = (pe_node_t *) iter->data;
+        GHashTableIter attr_iter;
+        const char *name = NULL;
+
+        g_hash_table_iter_init(&attr_iter, node->details->attrs);
+        while (g_hash_table_iter_next(&attr_iter, (gpointer *) &name, NULL)) {
+            if (node_attr_is_builtin(name)
+                || g_hash_table_lookup(referenced, name)
+                || g_hash_table_lookup(seen, name)) {
+                continue;
+            }
+            g_hash_table_insert(seen, (gpointer) name, (gpointer) name);
+
+            if (unused == NULL) {
+                unused = create_xml_node(data_set->graph,
+                                         PCMK__XE_UNUSED_NODE_ATTRS);
+            }
+            crm_xml_add(create_xml_node(unused, PCMK__XE_NODE_ATTRIBUTE),
+                        XML_NVPAIR_ATTR_NAME, name);
+        }
+    }
+    g_hash_table_destroy(referenced);
+    g_hash_table_destroy(seen);
+}
+
 static gboolean
 process_pe_message(xmlNode *msg, xmlNode *xml_data, pcmk__client_t *sender)
 {
@@ -82,11 +333,23 @@ process_pe_message(xmlNode *msg, xmlNode *xml_data, pcmk__client_t *sender)
         char *digest = NULL;
         const char *value = NULL;
         time_t execution_date = time(NULL);
+        xmlNode *input = NULL;
         xmlNode *converted = NULL;
         xmlNode *reply = NULL;
         gboolean is_repoke = FALSE;
         gboolean process = TRUE;
 
+        input = sched_input(msg, xml_data);
+        if (input == NULL) {
+            // Tell the controller to send the full CIB
+            reply = create_reply(msg, NULL);
+            CRM_ASSERT(reply != NULL);
+            crm_xml_add(reply, PCMK__XA_NEED_FULL_INPUT, XML_BOOLEAN_TRUE);
+            pcmk__ipc_send_xml(sender, 0, reply, crm_ipc_server_event);
+            free_xml(reply);
+            return TRUE;
+        }
+
         crm_config_error = FALSE;
         crm_config_warning = FALSE;
 
@@ -100,8 +363,8 @@ process_pe_message(xmlNode *msg, xmlNode *xml_data, pcmk__client_t *sender)
             set_bit(sched_data_set->flags, pe_flag_no_compat);
         }
 
-        digest = calculate_xml_versioned_digest(xml_data, FALSE, FALSE, CRM_FEATURE_SET);
-        converted = copy_xml(xml_data);
+        digest = calculate_xml_versioned_digest(input, FALSE, FALSE, CRM_FEATURE_SET);
+        converted = copy_xml(input);
         if (cli_config_update(&converted, NULL, TRUE) == FALSE) {
             sched_data_set->graph = create_xml_node(NULL, XML_TAG_GRAPH);
             crm_xml_add_int(sched_data_set->graph, "transition_id", 0);
@@ -121,6 +384,7 @@ process_pe_message(xmlNode *msg, xmlNode *xml_data, pcmk__client_t *sender)
 
         if (process) {
             pcmk__schedule_actions(sched_data_set, converted, NULL);
+            add_unused_node_attrs(sched_data_set);
         }
 
         series_id = get_series();
@@ -190,8 +454,8 @@ process_pe_message(xmlNode *msg, xmlNode *xml_data, pcmk__client_t *sender)
 
         if (is_repoke == FALSE && series_wrap != 0) {
             unlink(filename);
-            crm_xml_add_ll(xml_data, "execution-date", (long long) execution_date);
-            write_xml_file(xml_data, filename, TRUE);
+            crm_xml_add_ll(input, "execution-date", (long long) execution_date);
+            write_xml_file(input, filename, TRUE);
             pcmk__write_series_sequence(PE_STATE_DIR, series[series_id].name,
                                         ++seq, series_wrap);
         } else {
@@ -199,6 +463,7 @@ process_pe_message(xmlNode *msg, xmlNode *xml_data, pcmk__client_t *sender)
         }
 
         free_xml(converted);
+        free_xml(input);
     }
 
     return TRUE;
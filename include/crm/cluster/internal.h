@@ -124,6 +124,17 @@ ais_dest(const AIS_Host *host)
 
 #  define ais_data_len(msg) (msg->is_compressed?msg->compressed_size:msg->size)
 
+/* Message class (header.id) of a CPG message whose payload is a sequence of
+ * complete AIS_Message structures (each padded to 8-byte alignment) that share
+ * the same destination. Batches are unpacked by libcrmcluster before they
+ * reach a daemon's CPG delivery function. The value must not collide with any
+ * message class in use now or in the past (crm_class_cluster is 0, and the
+ * removed corosync 1 classes were 1 through 5), since older peers may still
+ * send those.
+ */
+#  define PCMK__CPG_CLASS_BATCH 64
+#  define PCMK__CPG_BATCH_ALIGN(len) (((len) + 7) & ~((size_t) 7))
+
 /*
 typedef enum {
    CS_OK = 1,
@@ -296,6 +307,7 @@ gboolean check_message_sanity(const AIS_Message * msg, const char *data);
 #  if SUPPORT_COROSYNC
 
 gboolean send_cpg_iov(struct iovec * iov);
+size_t pcmk__cpg_drain_queue(void);
 
 char *get_corosync_uuid(crm_node_t *peer);
 char *corosync_node_name(uint64_t /*cmap_handle_t */ cmap_handle, uint32_t nodeid);
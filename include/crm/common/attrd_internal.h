@@ -14,6 +14,7 @@
 extern "C" {
 #endif
 
+#  include <glib.h>                // GList
 #  include <crm/common/ipc.h>
 
 // Options for clients to use with functions below
@@ -29,6 +30,18 @@ int pcmk__node_attr_request(crm_ipc_t * ipc, char command, const char *host,
                             const char *dampen, const char *user_name,
                             int options);
 
+// One attribute update for pcmk__node_attr_request_bulk()
+typedef struct pcmk__node_attr_update_s {
+    const char *name;   // Name of attribute to set
+    const char *value;  // New value (or NULL to delete)
+    const char *host;   // Node to set it for (or NULL for local node)
+    const char *dampen; // New dampening (or NULL to leave unchanged)
+} pcmk__node_attr_update_t;
+
+int pcmk__node_attr_request_bulk(crm_ipc_t *ipc, GList *updates,
+                                 const char *section, const char *set,
+                                 const char *user_name, int options);
+
 int pcmk__node_attr_request_clear(crm_ipc_t *ipc, const char *host,
                                   const char *resource, const char *operation,
                                   const char *interval_spec,
@@ -46,6 +46,7 @@ int pcmk__substitute_secrets(const char *rsc_id, GHashTable *params);
 /* internal digest-related utilities (from digest.c) */
 
 bool pcmk__verify_digest(xmlNode *input, const char *expected);
+char *pcmk__rsc_history_digest(xmlNode *xml_rsc);
 
 
 /* internal I/O utilities (from io.c) */
@@ -171,6 +172,9 @@ bool pcmk__starts_with(const char *str, const char *prefix);
 bool pcmk__ends_with(const char *s, const char *match);
 bool pcmk__ends_with_ext(const char *s, const char *match);
 char *pcmk__add_word(char *list, const char *word);
+unsigned int pcmk__compress_bound(unsigned int length);
+int pcmk__compress_to_buffer(const char *data, unsigned int length,
+                             char *buffer, unsigned int *buffer_len);
 int pcmk__compress(const char *data, unsigned int length, unsigned int max,
                    char **result, unsigned int *result_len);
 
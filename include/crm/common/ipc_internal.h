@@ -13,6 +13,7 @@
 #include <sys/types.h>
 
 #include <crm_config.h>  /* US_AUTH_GETPEEREID */
+#include <crm/common/ipc.h>
 
 
 /* denotes "non yieldable PID" on FreeBSD, or actual PID1 in scenarios that
@@ -69,4 +70,6 @@
 int pcmk__ipc_is_authentic_process_active(const char *name, uid_t refuid,
                                           gid_t refgid, pid_t *gotpid);
 
+void pcmk__ipc_accept_binary(crm_ipc_t *client);
+
 #endif
@@ -25,6 +25,7 @@ extern "C" {
 #  include <crm/common/mainloop.h>
 
 typedef struct pcmk__client_s pcmk__client_t;
+typedef struct pcmk__ipc_shared_event_s pcmk__ipc_shared_event_t;
 
 enum pcmk__client_type {
     PCMK__CLIENT_IPC = 1,
@@ -57,6 +58,7 @@ struct pcmk__remote_s {
 enum pcmk__client_flags {
     pcmk__client_proxied    = 0x00001, /* ipc_proxy code only */
     pcmk__client_privileged = 0x00002, /* root or cluster user */
+    pcmk__client_binary     = 0x00004, /* client accepts binary-encoded messages */
 };
 
 struct pcmk__client_s {
@@ -121,6 +123,12 @@ int pcmk__ipc_prepare_iov(uint32_t request, xmlNode *message,
 int pcmk__ipc_send_xml(pcmk__client_t *c, uint32_t request, xmlNode *message,
                        uint32_t flags);
 int pcmk__ipc_send_iov(pcmk__client_t *c, struct iovec *iov, uint32_t flags);
+int pcmk__ipc_new_shared_event(xmlNode *message,
+                               pcmk__ipc_shared_event_t **event);
+void pcmk__ipc_free_shared_event(pcmk__ipc_shared_event_t *event);
+int pcmk__ipc_send_shared_event(pcmk__client_t *c,
+                                pcmk__ipc_shared_event_t *event,
+                                uint32_t flags);
 xmlNode *pcmk__client_data2xml(pcmk__client_t *c, void *data,
                                uint32_t *id, uint32_t *flags);
 
@@ -163,4 +163,11 @@ pcmk__xml_artefact_root(enum pcmk__xml_artefact_ns ns);
 char *pcmk__xml_artefact_path(enum pcmk__xml_artefact_ns ns,
                               const char *filespec);
 
+/* Compact binary encoding of XML messages (from xml_binary.c) */
+
+int pcmk__xml2binary(xmlNode *xml, char **result, size_t *length);
+xmlNode *pcmk__binary2xml(const char *data, size_t length);
+bool pcmk__xml_is_binary(const char *data, size_t length);
+xmlNode *pcmk__xml_from_message(const char *data, size_t length);
+
 #endif
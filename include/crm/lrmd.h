@@ -181,6 +181,9 @@ enum lrmd_call_options {
     lrmd_opt_drop_recurring = 0x00000003,
     /*! Send notifications for recurring operations only when the result changes */
     lrmd_opt_notify_changes_only = 0x00000004,
+    /*! Omit parameters from all but the first notification for a recurring
+     * operation (the client must remember them) */
+    lrmd_opt_notify_params_once = 0x00000008,
 };
 
 enum lrmd_callback_event {
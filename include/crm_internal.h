@@ -79,9 +79,12 @@ pid_t pcmk_locate_sbd(void);
  * XML attribute names used only by internal code
  */
 
+#define PCMK__XA_ADAPTIVE_LIMIT         "adaptive_limit"
 #define PCMK__XA_ATTR_DAMPENING         "attr_dampening"
 #define PCMK__XA_ATTR_FORCE             "attrd_is_force_write"
 #define PCMK__XA_ATTR_INTERVAL          "attr_clear_interval"
+#define PCMK__XA_ATTR_IS_ABSENT         "attr_is_absent"
+#define PCMK__XA_ATTR_IS_DELTA          "attr_is_delta"
 #define PCMK__XA_ATTR_IS_PRIVATE        "attr_is_private"
 #define PCMK__XA_ATTR_IS_REMOTE         "attr_is_remote"
 #define PCMK__XA_ATTR_NAME              "attr_name"
@@ -95,10 +98,45 @@ pid_t pcmk_locate_sbd(void);
 #define PCMK__XA_ATTR_USER              "attr_user"
 #define PCMK__XA_ATTR_UUID              "attr_key"
 #define PCMK__XA_ATTR_VALUE             "attr_value"
+#define PCMK__XA_ATTR_VALUE_DIGEST      "attr_value_digest"
+#define PCMK__XA_ATTR_VALUE_VERSION     "attr_value_version"
 #define PCMK__XA_ATTR_VERSION           "attr_version"
 #define PCMK__XA_ATTR_WRITER            "attr_writer"
+#define PCMK__XA_COUNT                  "count"
+#define PCMK__XA_CURRENT_MS             "current_ms"
+#define PCMK__XA_JOB_LIMIT              "job_limit"
+#define PCMK__XA_JOB_MAX                "job_max"
+#define PCMK__XA_LAST_MS                "last_ms"
+#define PCMK__XA_LIMIT_DECREASES        "limit_decreases"
+#define PCMK__XA_LOAD                   "load"
+#define PCMK__XA_MAX_MS                 "max_ms"
 #define PCMK__XA_MODE                   "mode"
+#define PCMK__XA_NEED_FULL_INPUT        "need_full_input"
+#define PCMK__XA_QUEUE_DEPTH            "queue_depth"
+#define PCMK__XA_QUEUE_MAX              "queue_max"
+#define PCMK__XA_REASON                 "reason"
 #define PCMK__XA_TASK                   "task"
+#define PCMK__XA_TOTAL_MS               "total_ms"
+#define PCMK__XA_UPPER_MS               "upper_ms"
+
+
+/*
+ * XML element names used only by internal code
+ */
+
+#define PCMK__XE_ACTION_LATENCY         "action_latency"
+#define PCMK__XE_CIB_PATCHES            "cib_patches"
+#define PCMK__XE_CONTROLLER_METRICS     "controller_metrics"
+#define PCMK__XE_FSA                    "fsa"
+#define PCMK__XE_FSA_STATE              "fsa_state"
+#define PCMK__XE_HISTORY_DIGESTS        "history_digests"
+#define PCMK__XE_JOB_LIMITS             "job_limits"
+#define PCMK__XE_LATENCY_BUCKET         "latency_bucket"
+#define PCMK__XE_NODE_ATTRIBUTE         "node_attribute"
+#define PCMK__XE_SCHEDULER              "scheduler"
+#define PCMK__XE_TRANSITION_ABORT       "transition_abort"
+#define PCMK__XE_UNCHANGED_HISTORY      "unchanged_history"
+#define PCMK__XE_UNUSED_NODE_ATTRS      "unused_node_attributes"
 
 
 /*
@@ -117,11 +155,13 @@ pid_t pcmk_locate_sbd(void);
 #define PCMK__ATTRD_CMD_UPDATE          "update"
 #define PCMK__ATTRD_CMD_UPDATE_BOTH     "update-both"
 #define PCMK__ATTRD_CMD_UPDATE_DELAY    "update-delay"
+#define PCMK__ATTRD_CMD_UPDATE_BULK     "update-bulk"
 #define PCMK__ATTRD_CMD_QUERY           "query"
 #define PCMK__ATTRD_CMD_REFRESH         "refresh"
 #define PCMK__ATTRD_CMD_FLUSH           "flush"
 #define PCMK__ATTRD_CMD_SYNC            "sync"
 #define PCMK__ATTRD_CMD_SYNC_RESPONSE   "sync-response"
+#define PCMK__ATTRD_CMD_SYNC_OFFER      "sync-offer"
 #define PCMK__ATTRD_CMD_CLEAR_FAILURE   "clear-failure"
 
 
@@ -39,6 +39,9 @@ typedef struct synapse_s {
 
     GListPtr actions;           /* crm_action_t* */
     GListPtr inputs;            /* crm_action_t* */
+
+    int pending_inputs;         // Number of inputs not yet confirmed
+    int tally;                  // How synapse is counted in graph totals
 } synapse_t;
 
 typedef struct crm_action_s {
@@ -58,6 +61,8 @@ typedef struct crm_action_s {
     gboolean failed;
     gboolean can_fail;
 
+    long long initiated_ms;     // Monotonic time when initiated (0 if not)
+
     xmlNode *xml;
 
 } crm_action_t;
@@ -101,6 +106,17 @@ struct crm_graph_s {
     GListPtr synapses;          /* synapse_t* */
 
     int migration_limit;
+
+    GHashTable *action_index;   // Action ID -> crm_action_t* (not inputs)
+    GHashTable *dependents;     // Action ID -> GList of synapse_t* that have
+                                // the action as an input
+    GQueue *ready;              // Synapses with all inputs confirmed that
+                                // haven't been fired, in the order they
+                                // became ready
+    GHashTable *cancel_index;   // Task key of cancelled op -> GList of
+                                // cancel crm_action_t*, in graph order
+    GHashTable *unused_attrs;   // Names of node attributes the graph does not
+                                // depend on (NULL if not known)
 };
 
 typedef struct crm_graph_functions_s {
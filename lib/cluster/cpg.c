@@ -47,13 +47,36 @@ gboolean(*pcmk_cpg_dispatch_fn) (int kind, const char *from, const char *data) =
         }                                               \
     } while(counter < max)
 
+static void cs_batch_flush(void);
+
+/* CPG connection context, owned by the library so that it doesn't depend on
+ * the lifetime of the caller's crm_cluster_t
+ */
+struct cpg_context_s {
+    cpg_deliver_fn_t deliver_fn;    // Daemon's delivery function
+};
+
+static void
+free_cpg_context(cpg_handle_t handle)
+{
+    struct cpg_context_s *context = NULL;
+
+    if ((cpg_context_get(handle, (void **) &context) == CS_OK)
+        && (context != NULL)) {
+        cpg_context_set(handle, NULL);
+        free(context);
+    }
+}
+
 void
 cluster_disconnect_cpg(crm_cluster_t *cluster)
 {
+    cs_batch_flush();
     pcmk_cpg_handle = 0;
     if (cluster->cpg_handle) {
         crm_trace("Disconnecting CPG");
         cpg_leave(cluster->cpg_handle, &cluster->group);
+        free_cpg_context(cluster->cpg_handle);
         cpg_finalize(cluster->cpg_handle);
         cluster->cpg_handle = 0;
 
@@ -130,7 +153,7 @@ bail:
 }
 
 
-GListPtr cs_message_queue = NULL;
+static GListPtr cs_message_queue = NULL;
 int cs_message_timer = 0;
 
 static ssize_t crm_cs_flush(gpointer data);
@@ -228,6 +251,237 @@ send_cpg_iov(struct iovec * iov)
     return TRUE;
 }
 
+/*!
+ * \internal
+ * \brief Discard all messages waiting to be sent via CPG
+ *
+ * \return Total size in bytes of the messages discarded
+ * \note This is intended for benchmarking message preparation without a CPG
+ *       connection, where nothing else would ever remove messages from the
+ *       queue.
+ */
+size_t
+pcmk__cpg_drain_queue(void)
+{
+    size_t bytes = 0;
+
+    while (cs_message_queue != NULL) {
+        struct iovec *iov = cs_message_queue->data;
+
+        bytes += iov->iov_len;
+        cs_message_queue = g_list_delete_link(cs_message_queue,
+                                              cs_message_queue);
+        free(iov->iov_base);
+        free(iov);
+    }
+    return bytes;
+}
+
+/* Small messages to the same destination may optionally be packed into a
+ * single CPG multicast (see PCMK_cpg_batch_delay), to reduce totem round trips
+ * under bursty load.
+ */
+#define CS_BATCH_MSG_MAX    (2 * 1024)  // Largest message that will be batched
+#define CS_BATCH_MAX        (32 * 1024) // Send a batch once it grows this big
+#define CS_BATCH_DELAY_MAX  1000        // Upper bound on flush delay (ms)
+
+static GList *cs_batch = NULL;      // Pending messages (most recent first)
+static size_t cs_batch_bytes = 0;   // Padded size of pending messages
+static guint cs_batch_timer = 0;
+
+/*!
+ * \internal
+ * \brief Get the configured batching delay for outgoing CPG messages
+ *
+ * \return Milliseconds to hold small messages for batching (0 to disable)
+ */
+static int
+cs_batch_delay(void)
+{
+    static int delay_ms = -1;
+
+    if (delay_ms < 0) {
+        const char *env = getenv("PCMK_cpg_batch_delay");
+
+        delay_ms = 0;
+        if (env != NULL) {
+            delay_ms = crm_parse_int(env, "0");
+            if (delay_ms < 0) {
+                crm_warn("Ignoring invalid value for PCMK_cpg_batch_delay: %s",
+                         env);
+                delay_ms = 0;
+            } else if (delay_ms > CS_BATCH_DELAY_MAX) {
+                delay_ms = CS_BATCH_DELAY_MAX;
+            }
+        }
+        if (delay_ms > 0) {
+            crm_info("Batching small CPG messages for up to %dms", delay_ms);
+        }
+    }
+    return delay_ms;
+}
+
+/*!
+ * \internal
+ * \brief Queue any pending batch of small CPG messages for sending
+ */
+static void
+cs_batch_flush(void)
+{
+    struct iovec *iov = NULL;
+    AIS_Message *batch = NULL;
+    AIS_Message *first = NULL;
+    size_t offset = 0;
+    int count = 0;
+
+    if (cs_batch_timer) {
+        g_source_remove(cs_batch_timer);
+        cs_batch_timer = 0;
+    }
+    if (cs_batch == NULL) {
+        return;
+    }
+
+    cs_batch = g_list_reverse(cs_batch);
+
+    if (cs_batch->next == NULL) {
+        // A lone message isn't worth wrapping
+        iov = cs_batch->data;
+        g_list_free(cs_batch);
+        cs_batch = NULL;
+        cs_batch_bytes = 0;
+        send_cpg_iov(iov);
+        return;
+    }
+
+    first = ((struct iovec *) cs_batch->data)->iov_base;
+    batch = calloc(1, sizeof(AIS_Message) + cs_batch_bytes);
+    CRM_ASSERT(batch != NULL);
+
+    batch->header.id = PCMK__CPG_CLASS_BATCH;
+    batch->header.error = CS_OK;
+    batch->header.size = sizeof(AIS_Message) + cs_batch_bytes;
+    batch->id = first->id;
+    batch->host = first->host;
+    batch->sender = first->sender;
+    batch->size = cs_batch_bytes;
+
+    for (GList *iter = cs_batch; iter != NULL; iter = iter->next) {
+        struct iovec *msg_iov = iter->data;
+
+        memcpy(batch->data + offset, msg_iov->iov_base, msg_iov->iov_len);
+        offset += PCMK__CPG_BATCH_ALIGN(msg_iov->iov_len);
+        count++;
+
+        free(msg_iov->iov_base);
+        free(msg_iov);
+    }
+    g_list_free(cs_batch);
+    cs_batch = NULL;
+    cs_batch_bytes = 0;
+
+    crm_trace("Queueing batch of %d CPG messages to %s (%u bytes)",
+              count, ais_dest(&(batch->host)), batch->header.size);
+
+    iov = calloc(1, sizeof(struct iovec));
+    CRM_ASSERT(iov != NULL);
+    iov->iov_base = batch;
+    iov->iov_len = batch->header.size;
+    send_cpg_iov(iov);
+}
+
+static gboolean
+cs_batch_flush_cb(gpointer data)
+{
+    cs_batch_timer = 0;
+    cs_batch_flush();
+    return FALSE;
+}
+
+/*!
+ * \internal
+ * \brief Send a CPG message, batching it with others if appropriate
+ *
+ * \param[in] iov  I/O vector containing a single AIS_Message (takes ownership)
+ */
+static void
+cs_send_or_batch(struct iovec *iov)
+{
+    AIS_Message *msg = iov->iov_base;
+    int delay_ms = cs_batch_delay();
+
+    if ((delay_ms == 0) || (iov->iov_len > CS_BATCH_MSG_MAX)) {
+        // Flush first, so messages are sent in the order they were created
+        cs_batch_flush();
+        send_cpg_iov(iov);
+        return;
+    }
+
+    if (cs_batch != NULL) {
+        AIS_Message *pending = ((struct iovec *) cs_batch->data)->iov_base;
+
+        if ((memcmp(&(pending->host), &(msg->host), sizeof(AIS_Host)) != 0)
+            || ((cs_batch_bytes + PCMK__CPG_BATCH_ALIGN(iov->iov_len))
+                > CS_BATCH_MAX)) {
+            cs_batch_flush();
+        }
+    }
+
+    cs_batch = g_list_prepend(cs_batch, iov);
+    cs_batch_bytes += PCMK__CPG_BATCH_ALIGN(iov->iov_len);
+    if (cs_batch_timer == 0) {
+        cs_batch_timer = g_timeout_add(delay_ms, cs_batch_flush_cb, NULL);
+    }
+}
+
+/*!
+ * \internal
+ * \brief Deliver a CPG message to a daemon, unpacking it if it is a batch
+ *
+ * This is registered as the CPG delivery function for all connections, so
+ * daemons' own delivery functions only ever see individual messages.
+ */
+static void
+pcmk_cpg_deliver(cpg_handle_t handle, const struct cpg_name *groupName,
+                 uint32_t nodeid, uint32_t pid, void *content, size_t msg_len)
+{
+    struct cpg_context_s *context = NULL;
+    AIS_Message *batch = content;
+    size_t offset = 0;
+    size_t data_len = 0;
+
+    if ((cpg_context_get(handle, (void **) &context) != CS_OK)
+        || (context == NULL) || (context->deliver_fn == NULL)) {
+        crm_err("Discarding CPG message from node %u: no handler", nodeid);
+        return;
+    }
+
+    if ((msg_len < sizeof(AIS_Message))
+        || (batch->header.id != PCMK__CPG_CLASS_BATCH)) {
+        context->deliver_fn(handle, groupName, nodeid, pid, content, msg_len);
+        return;
+    }
+
+    data_len = QB_MIN(batch->size, msg_len - sizeof(AIS_Message));
+    crm_trace("Unpacking batch of CPG messages from node %u (%llu bytes)",
+              nodeid, (unsigned long long) data_len);
+
+    while ((offset + sizeof(AIS_Message)) <= data_len) {
+        AIS_Message *msg = (AIS_Message *) (batch->data + offset);
+
+        if ((msg->header.size < sizeof(AIS_Message))
+            || (msg->header.size > (data_len - offset))) {
+            crm_err("Discarding remainder of invalid CPG batch from node %u "
+                    CRM_XS " offset=%llu size=%u", nodeid,
+                    (unsigned long long) offset, msg->header.size);
+            break;
+        }
+        context->deliver_fn(handle, groupName, nodeid, pid, msg,
+                            msg->header.size);
+        offset += PCMK__CPG_BATCH_ALIGN(msg->header.size);
+    }
+}
+
 static int
 pcmk_cpg_dispatch(gpointer user_data)
 {
@@ -542,6 +796,7 @@ cluster_connect_cpg(crm_cluster_t *cluster)
     uint32_t id = 0;
     crm_node_t *peer = NULL;
     cpg_handle_t handle = 0;
+    struct cpg_context_s *context = NULL;
     const char *message_name = pcmk_message_name(crm_system_name);
     uid_t found_uid = 0;
     gid_t found_gid = 0;
@@ -554,9 +809,9 @@ cluster_connect_cpg(crm_cluster_t *cluster)
     };
 
     cpg_callbacks_t cpg_callbacks = {
-        .cpg_deliver_fn = cluster->cpg.cpg_deliver_fn,
+        // Unpacks batched messages before calling cluster->cpg.cpg_deliver_fn
+        .cpg_deliver_fn = pcmk_cpg_deliver,
         .cpg_confchg_fn = cluster->cpg.cpg_confchg_fn,
-        /* .cpg_deliver_fn = pcmk_cpg_deliver, */
         /* .cpg_confchg_fn = pcmk_cpg_membership, */
     };
 
@@ -576,6 +831,16 @@ cluster_connect_cpg(crm_cluster_t *cluster)
         goto bail;
     }
 
+    context = calloc(1, sizeof(struct cpg_context_s));
+    CRM_ASSERT(context != NULL);
+    context->deliver_fn = cluster->cpg.cpg_deliver_fn;
+    rc = cpg_context_set(handle, context);
+    if (rc != CS_OK) {
+        crm_err("Could not set CPG context: %s (%d)", cs_strerror(rc), rc);
+        free(context);
+        goto bail;
+    }
+
     rc = cpg_fd_get(handle, &fd);
     if (rc != CS_OK) {
         crm_err("Could not obtain the CPG API connection: %s (%d)",
@@ -620,6 +885,7 @@ cluster_connect_cpg(crm_cluster_t *cluster)
 
   bail:
     if (rc != CS_OK) {
+        free_cpg_context(handle);
         cpg_finalize(handle);
         return FALSE;
     }
@@ -725,27 +991,23 @@ send_cluster_text(enum crm_ais_msg_class msg_class, const char *data,
         memcpy(msg->data, data, msg->size);
 
     } else {
-        char *compressed = NULL;
-        unsigned int new_size = 0;
-        char *uncompressed = strdup(data);
+        /* Compress straight from the caller's buffer into the message, then
+         * give back whatever space compression saved
+         */
+        unsigned int new_size = pcmk__compress_bound(msg->size);
 
-        if (pcmk__compress(uncompressed, (unsigned int) msg->size, 0,
-                           &compressed, &new_size) == pcmk_rc_ok) {
+        msg = realloc_safe(msg, sizeof(AIS_Message) + new_size);
+        if (pcmk__compress_to_buffer(data, (unsigned int) msg->size,
+                                     msg->data, &new_size) == pcmk_rc_ok) {
 
             msg->header.size = sizeof(AIS_Message) + new_size;
-            msg = realloc_safe(msg, msg->header.size);
-            memcpy(msg->data, compressed, new_size);
-
             msg->is_compressed = TRUE;
             msg->compressed_size = new_size;
 
         } else {
-            msg = realloc_safe(msg, msg->header.size);
             memcpy(msg->data, data, msg->size);
         }
-
-        free(uncompressed);
-        free(compressed);
+        msg = realloc_safe(msg, msg->header.size);
     }
 
     iov = calloc(1, sizeof(struct iovec));
@@ -763,7 +1025,7 @@ send_cluster_text(enum crm_ais_msg_class msg_class, const char *data,
     }
     free(target);
 
-    send_cpg_iov(iov);
+    cs_send_or_batch(iov);
 
     return TRUE;
 }
@@ -106,6 +106,26 @@ send_attrd_op(crm_ipc_t *ipc, xmlNode *attrd_op)
     return pcmk_legacy2rc(rc);
 }
 
+/*!
+ * \internal
+ * \brief Map common aliases for an attribute section to the real name
+ *
+ * \param[in] section  Section name or alias given by user
+ *
+ * \return Section name to use
+ */
+static const char *
+remap_section(const char *section)
+{
+    if (safe_str_eq(section, "reboot")) {
+        return XML_CIB_TAG_STATUS;
+
+    } else if (safe_str_eq(section, "forever")) {
+        return XML_CIB_TAG_NODES;
+    }
+    return section;
+}
+
 /*!
  * \internal
  * \brief Send a request to pacemaker-attrd
@@ -144,13 +164,7 @@ pcmk__node_attr_request(crm_ipc_t *ipc, char command, const char *host,
     const char *display_command = NULL; /* for commands without name/value */
     xmlNode *update = create_attrd_op(user_name);
 
-    /* remap common aliases */
-    if (safe_str_eq(section, "reboot")) {
-        section = XML_CIB_TAG_STATUS;
-
-    } else if (safe_str_eq(section, "forever")) {
-        section = XML_CIB_TAG_NODES;
-    }
+    section = remap_section(section);
 
     if (name == NULL && command == 'U') {
         command = 'R';
@@ -223,6 +237,72 @@ done:
     return rc;
 }
 
+/*!
+ * \internal
+ * \brief Send a request to pacemaker-attrd to update many attributes at once
+ *
+ * All of the updates are broadcast to the cluster in a single message and
+ * applied together by every pacemaker-attrd.
+ *
+ * \param[in] ipc        Connection to pacemaker-attrd (or NULL to use a local
+ *                       connection)
+ * \param[in] updates    List of pcmk__node_attr_update_t to apply
+ * \param[in] section    Status or nodes
+ * \param[in] set        ID of attribute set to use (or NULL to choose first)
+ * \param[in] user_name  ACL user to pass to pacemaker-attrd
+ * \param[in] options    Bitmask of pcmk__node_attr_opts
+ *
+ * \return Standard Pacemaker return code
+ */
+int
+pcmk__node_attr_request_bulk(crm_ipc_t *ipc, GList *updates,
+                             const char *section, const char *set,
+                             const char *user_name, int options)
+{
+    int rc = pcmk_rc_ok;
+    int count = 0;
+    xmlNode *request = NULL;
+
+    if (updates == NULL) {
+        return EINVAL;
+    }
+
+    request = create_attrd_op(user_name);
+    crm_xml_add(request, PCMK__XA_TASK, PCMK__ATTRD_CMD_UPDATE_BULK);
+    section = remap_section(section);
+
+    for (GList *iter = updates; iter != NULL; iter = iter->next) {
+        pcmk__node_attr_update_t *update = iter->data;
+        xmlNode *child = NULL;
+
+        if ((update == NULL) || (update->name == NULL)) {
+            rc = EINVAL;
+            goto done;
+        }
+
+        child = create_xml_node(request, XML_CIB_TAG_NVPAIR);
+        crm_xml_add(child, PCMK__XA_ATTR_NAME, update->name);
+        crm_xml_add(child, PCMK__XA_ATTR_VALUE, update->value);
+        crm_xml_add(child, PCMK__XA_ATTR_NODE_NAME, update->host);
+        crm_xml_add(child, PCMK__XA_ATTR_DAMPENING, update->dampen);
+        crm_xml_add(child, PCMK__XA_ATTR_SECTION, section);
+        crm_xml_add(child, PCMK__XA_ATTR_SET, set);
+        crm_xml_add_int(child, PCMK__XA_ATTR_IS_REMOTE,
+                        is_set(options, pcmk__node_attr_remote));
+        crm_xml_add_int(child, PCMK__XA_ATTR_IS_PRIVATE,
+                        is_set(options, pcmk__node_attr_private));
+        count++;
+    }
+
+    rc = send_attrd_op(ipc, request);
+
+done:
+    free_xml(request);
+    crm_debug("Asked pacemaker-attrd to update %d attribute%s: %s (%d)",
+              count, pcmk__plural_s(count), pcmk_rc_str(rc), rc);
+    return rc;
+}
+
 /*!
  * \internal
  * \brief Send a request to pacemaker-attrd to clear resource failure
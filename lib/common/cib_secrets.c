@@ -31,6 +31,20 @@ static char *read_local_file(char *local_file);
 #define MAX_VALUE_LEN 255
 #define MAGIC "lrm://"
 
+/* Secrets that have already been verified, keyed by the path of the secret
+ * file, so that (for example) recurring monitors don't re-read the checksum
+ * file each time. Only the verified checksum is kept, never the secret itself;
+ * the secret is re-read whenever it is needed and checked against the cached
+ * checksum.
+ */
+struct verified_secret_s {
+    struct stat value_st;   // Identity of secret file when verified
+    struct stat sign_st;    // Identity of checksum file when verified
+    char *hash;             // Verified checksum of secret
+};
+
+static GHashTable *verified_secrets = NULL;
+
 static int
 is_magic_value(char *p)
 {
@@ -52,6 +66,101 @@ check_md5_hash(char *hash, char *value)
     return rc;
 }
 
+static void
+free_verified_secret(gpointer data)
+{
+    struct verified_secret_s *secret = data;
+
+    free(secret->hash);
+    free(secret);
+}
+
+static bool
+same_file(const struct stat *st1, const struct stat *st2)
+{
+    return (st1->st_ino == st2->st_ino) && (st1->st_dev == st2->st_dev)
+           && (st1->st_size == st2->st_size)
+           && (st1->st_mtim.tv_sec == st2->st_mtim.tv_sec)
+           && (st1->st_mtim.tv_nsec == st2->st_mtim.tv_nsec)
+           && (st1->st_ctim.tv_sec == st2->st_ctim.tv_sec)
+           && (st1->st_ctim.tv_nsec == st2->st_ctim.tv_nsec);
+}
+
+/*!
+ * \internal
+ * \brief Get a previously verified secret, if its files are unchanged
+ *
+ * \param[in]  local_file  Secret file
+ * \param[in]  hash_file   Checksum file for \p local_file
+ * \param[out] value_st    Where to store current identity of \p local_file
+ * \param[out] sign_st     Where to store current identity of \p hash_file
+ *
+ * \return Newly read secret if previously verified, its files are unchanged,
+ *         and it still matches the verified checksum, otherwise NULL
+ */
+static char *
+cached_secret(const char *local_file, const char *hash_file,
+              struct stat *value_st, struct stat *sign_st)
+{
+    struct verified_secret_s *secret = NULL;
+    char *value = NULL;
+
+    if ((stat(local_file, value_st) < 0) || (stat(hash_file, sign_st) < 0)) {
+        // Let the caller report the error, and don't cache anything
+        memset(value_st, 0, sizeof(struct stat));
+        if (verified_secrets != NULL) {
+            g_hash_table_remove(verified_secrets, local_file);
+        }
+        return NULL;
+    }
+    if (verified_secrets != NULL) {
+        secret = g_hash_table_lookup(verified_secrets, local_file);
+    }
+    if ((secret == NULL) || !same_file(&(secret->value_st), value_st)
+        || !same_file(&(secret->sign_st), sign_st)) {
+        return NULL;
+    }
+
+    value = read_local_file((char *) local_file);
+    if ((value != NULL) && !check_md5_hash(secret->hash, value)) {
+        // Changed without any visible change in identity, so verify afresh
+        free(value);
+        value = NULL;
+    }
+    if (value == NULL) {
+        g_hash_table_remove(verified_secrets, local_file);
+    }
+    return value;
+}
+
+static void
+cache_secret(const char *local_file, const char *hash,
+             const struct stat *value_st, const struct stat *sign_st)
+{
+    struct verified_secret_s *secret = NULL;
+
+    if (value_st->st_ino == 0) { // Files couldn't be checked beforehand
+        return;
+    }
+    secret = calloc(1, sizeof(struct verified_secret_s));
+    if (secret == NULL) {
+        return;
+    }
+    secret->hash = strdup(hash);
+    if (secret->hash == NULL) {
+        free(secret);
+        return;
+    }
+    secret->value_st = *value_st;
+    secret->sign_st = *sign_st;
+
+    if (verified_secrets == NULL) {
+        verified_secrets = g_hash_table_new_full(crm_str_hash, g_str_equal,
+                                                 free, free_verified_secret);
+    }
+    g_hash_table_replace(verified_secrets, strdup(local_file), secret);
+}
+
 static char *
 read_local_file(char *local_file)
 {
@@ -99,6 +208,7 @@ pcmk__substitute_secrets(const char *rsc_id, GHashTable *params)
     char hash_file[FILENAME_MAX+1], *hash;
     GList *secret_params = NULL, *l;
     char *key, *pvalue, *secret_value;
+    struct stat value_st, sign_st;
     int rc = pcmk_rc_ok;
 
     if (params == NULL) {
@@ -139,24 +249,32 @@ pcmk__substitute_secrets(const char *rsc_id, GHashTable *params)
         }
 
         strcpy(start_pname, key);
-        secret_value = read_local_file(local_file);
-        if (!secret_value) {
-            crm_err("secret for rsc %s parameter %s not found in %s",
-                    rsc_id, key, LRM_CIBSECRETS_DIR);
-            rc = ENOENT;
-            continue;
-        }
-
         strcpy(hash_file, local_file);
         if (strlen(hash_file) + 5 > FILENAME_MAX) {
             crm_err("cannot build such a long name "
                     "for the sign file: %s.sign", hash_file);
-            free(secret_value);
             rc = ENAMETOOLONG;
             continue;
+        }
+        strncat(hash_file, ".sign", 5);
+
+        secret_value = cached_secret(local_file, hash_file, &value_st,
+                                     &sign_st);
+        if (secret_value != NULL) {
+            crm_trace("Using verified secret for rsc %s parameter %s",
+                      rsc_id, key);
+            g_hash_table_replace(params, strdup(key), secret_value);
+            continue;
+        }
+
+        secret_value = read_local_file(local_file);
+        if (!secret_value) {
+            crm_err("secret for rsc %s parameter %s not found in %s",
+                    rsc_id, key, LRM_CIBSECRETS_DIR);
+            rc = ENOENT;
+            continue;
 
         } else {
-            strncat(hash_file, ".sign", 5);
             hash = read_local_file(hash_file);
             if (hash == NULL) {
                 crm_err("md5 sum for rsc %s parameter %s "
@@ -173,6 +291,7 @@ pcmk__substitute_secrets(const char *rsc_id, GHashTable *params)
                 rc = pcmk_rc_cib_corrupt;
                 continue;
             }
+            cache_secret(local_file, hash, &value_st, &sign_st);
             free(hash);
         }
         g_hash_table_replace(params, strdup(key), secret_value);
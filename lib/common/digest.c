@@ -236,3 +236,67 @@ pcmk__verify_digest(xmlNode *input, const char *expected)
     free(calculated);
     return passed;
 }
+
+static gint
+sort_by_id(gconstpointer a, gconstpointer b)
+{
+    return strcmp(crm_str(ID((const xmlNode *) a)),
+                  crm_str(ID((const xmlNode *) b)));
+}
+
+/* Attributes recording who wrote a resource history entry rather than what
+ * it says, so they differ between history written by the CIB and the same
+ * history rebuilt by the executor
+ */
+static const char *volatile_history_attrs[] = {
+    XML_ATTR_ORIGIN,
+    XML_ATTR_UPDATE_ORIG,
+    XML_ATTR_UPDATE_CLIENT,
+    XML_ATTR_UPDATE_USER,
+};
+
+static void
+remove_volatile_history_attrs(xmlNode *xml)
+{
+    for (int lpc = 0; lpc < DIMOF(volatile_history_attrs); lpc++) {
+        xml_remove_prop(xml, volatile_history_attrs[lpc]);
+    }
+}
+
+/*!
+ * \internal
+ * \brief Calculate a digest of one resource's operation history
+ *
+ * The digest does not depend on the order of the history entries or on
+ * attributes recording where an entry came from (such as crm-debug-origin), so
+ * a resource history rebuilt by the executor and the same history read back
+ * from the CIB give the same digest.
+ *
+ * \param[in] xml_rsc  Resource history (lrm_resource) XML
+ *
+ * \return Newly allocated digest (caller is responsible for freeing)
+ */
+char *
+pcmk__rsc_history_digest(xmlNode *xml_rsc)
+{
+    GList *ops = NULL;
+    char *digest = NULL;
+    xmlNode *copy = create_xml_node(NULL, XML_LRM_TAG_RESOURCE);
+
+    copy_in_properties(copy, xml_rsc);
+    remove_volatile_history_attrs(copy);
+    for (xmlNode *op = __xml_first_child_element(xml_rsc); op != NULL;
+         op = __xml_next_element(op)) {
+        ops = g_list_prepend(ops, op);
+    }
+    ops = g_list_sort(ops, sort_by_id);
+    for (GList *iter = ops; iter != NULL; iter = iter->next) {
+        remove_volatile_history_attrs(add_node_copy(copy,
+                                                    (xmlNode *) iter->data));
+    }
+    g_list_free(ops);
+
+    digest = calculate_operation_digest(copy, NULL);
+    free_xml(copy);
+    return digest;
+}
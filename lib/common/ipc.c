@@ -38,6 +38,7 @@
 #include <crm/common/ipcs_internal.h>
 
 #include <crm/common/ipc_internal.h>  /* PCMK__SPECIAL_PID* */
+#include <crm/common/xml_internal.h>
 
 #define PCMK_IPC_VERSION 1
 
@@ -52,7 +53,28 @@ struct crm_ipc_response_header {
     uint8_t  version; /* Protect against version changes for anyone that might bother to statically link us */
 };
 
+/* A serialized (and possibly compressed) event that may be queued for any
+ * number of clients without copying the payload. Each queued copy holds a
+ * reference, and the payload is freed when the last reference is dropped.
+ */
+struct pcmk__ipc_shared_event_s {
+    unsigned int refcount;
+    struct crm_ipc_response_header header;  // Template for per-client headers
+    void *payload;
+    size_t payload_len;
+};
+
+/* An entry in a client's event queue. The header in iov[0] is always private
+ * to the client (flags and ID may differ per client), while the payload in
+ * iov[1] belongs to the shared event if there is one.
+ */
+typedef struct ipc_queued_event_s {
+    struct iovec *iov;
+    pcmk__ipc_shared_event_t *shared;
+} ipc_queued_event_t;
+
 static int hdr_offset = 0;
+static uint32_t next_event_id = 1;
 static unsigned int ipc_buffer_max = 0;
 static unsigned int pick_ipc_buffer(unsigned int max);
 
@@ -473,16 +495,42 @@ pcmk_free_ipc_event(struct iovec *event)
 static void
 free_event(gpointer data)
 {
-    pcmk_free_ipc_event((struct iovec *) data);
+    ipc_queued_event_t *event = data;
+
+    if (event->shared == NULL) {
+        pcmk_free_ipc_event(event->iov);
+    } else {
+        free(event->iov[0].iov_base);
+        free(event->iov);
+        pcmk__ipc_free_shared_event(event->shared);
+    }
+    free(event);
 }
 
+/*!
+ * \internal
+ * \brief Queue an event for a client
+ *
+ * \param[in,out] c       Client to queue event for
+ * \param[in]     iov     I/O vector to queue (queue takes ownership)
+ * \param[in]     shared  If not NULL, owner of the payload in \p iov[1]
+ */
 static void
-add_event(pcmk__client_t *c, struct iovec *iov)
+add_event(pcmk__client_t *c, struct iovec *iov,
+          pcmk__ipc_shared_event_t *shared)
 {
+    ipc_queued_event_t *event = calloc(1, sizeof(ipc_queued_event_t));
+
+    CRM_ASSERT(event != NULL);
+    event->iov = iov;
+    if (shared != NULL) {
+        shared->refcount++;
+        event->shared = shared;
+    }
     if (c->event_queue == NULL) {
         c->event_queue = g_queue_new();
     }
-    g_queue_push_tail(c->event_queue, iov);
+    g_queue_push_tail(c->event_queue, event);
 }
 
 void
@@ -597,6 +645,13 @@ pcmk__client_data2xml(pcmk__client_t *c, void *data, uint32_t *id,
         c->flags |= pcmk__client_proxied;
     }
 
+    if (is_set(header->flags, crm_ipc_binary_ok)
+        && is_not_set(c->flags, pcmk__client_binary)) {
+        crm_trace("Client %s accepts binary-encoded messages",
+                  pcmk__client_name(c));
+        c->flags |= pcmk__client_binary;
+    }
+
     if(header->version > PCMK_IPC_VERSION) {
         crm_err("Filtering incompatible v%d IPC message, we only support versions <= %d",
                 header->version, PCMK_IPC_VERSION);
@@ -624,7 +679,7 @@ pcmk__client_data2xml(pcmk__client_t *c, void *data, uint32_t *id,
 
     CRM_ASSERT(text[header->size_uncompressed - 1] == 0);
 
-    xml = string2xml(text);
+    xml = pcmk__xml_from_message(text, header->size_uncompressed);
     crm_log_xml_trace(xml, "[IPC received]");
 
     free(uncompressed);
@@ -689,7 +744,7 @@ crm_ipcs_flush_events(pcmk__client_t *c)
     }
     while (sent < 100) {
         struct crm_ipc_response_header *header = NULL;
-        struct iovec *event = NULL;
+        ipc_queued_event_t *event = NULL;
 
         if (c->event_queue) {
             // We don't pop unless send is successful
@@ -699,7 +754,7 @@ crm_ipcs_flush_events(pcmk__client_t *c)
             break;
         }
 
-        qb_rc = qb_ipcs_event_sendv(c->ipcs, event, 2);
+        qb_rc = qb_ipcs_event_sendv(c->ipcs, event->iov, 2);
         if (qb_rc < 0) {
             rc = (int) -qb_rc;
             break;
@@ -707,16 +762,18 @@ crm_ipcs_flush_events(pcmk__client_t *c)
         event = g_queue_pop_head(c->event_queue);
 
         sent++;
-        header = event[0].iov_base;
+        header = event->iov[0].iov_base;
         if (header->size_compressed) {
-            crm_trace("Event %d to %p[%d] (%lld compressed bytes) sent",
-                      header->qb.id, c->ipcs, c->pid, (long long) qb_rc);
+            crm_trace("Event %d to %p[%d] (%lld compressed bytes) sent%s",
+                      header->qb.id, c->ipcs, c->pid, (long long) qb_rc,
+                      ((event->shared == NULL)? "" : " (shared)"));
         } else {
-            crm_trace("Event %d to %p[%d] (%lld bytes) sent: %.120s",
+            crm_trace("Event %d to %p[%d] (%lld bytes) sent%s: %.120s",
                       header->qb.id, c->ipcs, c->pid, (long long) qb_rc,
-                      (char *) (event[1].iov_base));
+                      ((event->shared == NULL)? "" : " (shared)"),
+                      (char *) (event->iov[1].iov_base));
         }
-        pcmk_free_ipc_event(event);
+        free_event(event);
     }
 
     queue_len -= sent;
@@ -759,20 +816,20 @@ crm_ipcs_flush_events(pcmk__client_t *c)
 
 /*!
  * \internal
- * \brief Create an I/O vector for sending an IPC XML message
+ * \brief Create an I/O vector for sending an IPC message
  *
  * \param[in]  request        Identifier for libqb response header
  * \param[in]  message        XML message to send
  * \param[in]  max_send_size  If 0, default IPC buffer size is used
+ * \param[in]  binary         If TRUE, use binary encoding when possible
  * \param[out] result         Where to store prepared I/O vector
  * \param[out] bytes          Size of prepared data in bytes
  *
  * \return Standard Pacemaker return code
  */
-int
-pcmk__ipc_prepare_iov(uint32_t request, xmlNode *message,
-                      uint32_t max_send_size, struct iovec **result,
-                      ssize_t *bytes)
+static int
+prepare_iov(uint32_t request, xmlNode *message, uint32_t max_send_size,
+            bool binary, struct iovec **result, ssize_t *bytes)
 {
     static unsigned int biggest = 0;
     struct iovec *iov;
@@ -790,7 +847,21 @@ pcmk__ipc_prepare_iov(uint32_t request, xmlNode *message,
         return errno;
     }
 
-    buffer = dump_xml_unformatted(message);
+    header->version = PCMK_IPC_VERSION;
+    if (binary) {
+        size_t len = 0;
+
+        if (pcmk__xml2binary(message, &buffer, &len) == pcmk_rc_ok) {
+            header->size_uncompressed = len;
+        } else {
+            crm_trace("Sending %s as text: no binary representation",
+                      crm_element_name(message));
+        }
+    }
+    if (buffer == NULL) {
+        buffer = dump_xml_unformatted(message);
+        header->size_uncompressed = 1 + strlen(buffer);
+    }
     crm_ipc_init();
 
     if (max_send_size == 0) {
@@ -803,8 +874,6 @@ pcmk__ipc_prepare_iov(uint32_t request, xmlNode *message,
     iov[0].iov_len = hdr_offset;
     iov[0].iov_base = header;
 
-    header->version = PCMK_IPC_VERSION;
-    header->size_uncompressed = 1 + strlen(buffer);
     total = iov[0].iov_len + header->size_uncompressed;
 
     if (total < max_send_size) {
@@ -855,11 +924,30 @@ pcmk__ipc_prepare_iov(uint32_t request, xmlNode *message,
     return pcmk_rc_ok;
 }
 
+/*!
+ * \internal
+ * \brief Create an I/O vector for sending an IPC XML message
+ *
+ * \param[in]  request        Identifier for libqb response header
+ * \param[in]  message        XML message to send
+ * \param[in]  max_send_size  If 0, default IPC buffer size is used
+ * \param[out] result         Where to store prepared I/O vector
+ * \param[out] bytes          Size of prepared data in bytes
+ *
+ * \return Standard Pacemaker return code
+ */
+int
+pcmk__ipc_prepare_iov(uint32_t request, xmlNode *message,
+                      uint32_t max_send_size, struct iovec **result,
+                      ssize_t *bytes)
+{
+    return prepare_iov(request, message, max_send_size, FALSE, result, bytes);
+}
+
 int
 pcmk__ipc_send_iov(pcmk__client_t *c, struct iovec *iov, uint32_t flags)
 {
     int rc = pcmk_rc_ok;
-    static uint32_t id = 1;
     struct crm_ipc_response_header *header = iov[0].iov_base;
 
     if (c->flags & pcmk__client_proxied) {
@@ -872,13 +960,14 @@ pcmk__ipc_send_iov(pcmk__client_t *c, struct iovec *iov, uint32_t flags)
         }
     }
 
-    header->flags |= flags;
+    // All servers decode binary requests (see pcmk__client_data2xml())
+    header->flags |= flags | crm_ipc_binary_ok;
     if (flags & crm_ipc_server_event) {
-        header->qb.id = id++;   /* We don't really use it, but doesn't hurt to set one */
+        header->qb.id = next_event_id++;   /* We don't really use it, but doesn't hurt to set one */
 
         if (flags & crm_ipc_server_free) {
             crm_trace("Sending the original to %p[%d]", c->ipcs, c->pid);
-            add_event(c, iov);
+            add_event(c, iov, NULL);
 
         } else {
             struct iovec *iov_copy = pcmk__new_ipc_event();
@@ -892,7 +981,7 @@ pcmk__ipc_send_iov(pcmk__client_t *c, struct iovec *iov, uint32_t flags)
             iov_copy[1].iov_base = malloc(iov[1].iov_len);
             memcpy(iov_copy[1].iov_base, iov[1].iov_base, iov[1].iov_len);
 
-            add_event(c, iov_copy);
+            add_event(c, iov_copy, NULL);
         }
 
     } else {
@@ -943,7 +1032,8 @@ pcmk__ipc_send_xml(pcmk__client_t *c, uint32_t request, xmlNode *message,
         return EINVAL;
     }
     crm_ipc_init();
-    rc = pcmk__ipc_prepare_iov(request, message, ipc_buffer_max, &iov, NULL);
+    rc = prepare_iov(request, message, ipc_buffer_max,
+                     is_set(c->flags, pcmk__client_binary), &iov, NULL);
     if (rc == pcmk_rc_ok) {
         rc = pcmk__ipc_send_iov(c, iov, flags | crm_ipc_server_free);
     } else {
@@ -954,6 +1044,126 @@ pcmk__ipc_send_xml(pcmk__client_t *c, uint32_t request, xmlNode *message,
     return rc;
 }
 
+/*!
+ * \internal
+ * \brief Serialize an XML message once for sending to many clients as an event
+ *
+ * \param[in]  message  XML message to send
+ * \param[out] event    Where to store newly allocated shared event
+ *
+ * \return Standard Pacemaker return code
+ * \note The caller is responsible for releasing its reference to the result
+ *       with pcmk__ipc_free_shared_event(). Clients' event queues hold their
+ *       own references, so this may be done as soon as the event has been
+ *       passed to pcmk__ipc_send_shared_event() for each recipient.
+ */
+int
+pcmk__ipc_new_shared_event(xmlNode *message, pcmk__ipc_shared_event_t **event)
+{
+    struct iovec *iov = NULL;
+    pcmk__ipc_shared_event_t *shared = NULL;
+    int rc = pcmk_rc_ok;
+
+    if (event == NULL) {
+        return EINVAL;
+    }
+    *event = NULL;
+
+    crm_ipc_init();
+    rc = pcmk__ipc_prepare_iov(0, message, ipc_buffer_max, &iov, NULL);
+    if (rc != pcmk_rc_ok) {
+        return rc;
+    }
+
+    shared = calloc(1, sizeof(pcmk__ipc_shared_event_t));
+    if (shared == NULL) {
+        rc = errno;
+        pcmk_free_ipc_event(iov);
+        return rc;
+    }
+
+    // Keep the header as a template, and take ownership of the payload
+    memcpy(&(shared->header), iov[0].iov_base, sizeof(shared->header));
+    shared->payload = iov[1].iov_base;
+    shared->payload_len = iov[1].iov_len;
+    shared->refcount = 1;
+    free(iov[0].iov_base);
+    free(iov);
+
+    *event = shared;
+    return pcmk_rc_ok;
+}
+
+/*!
+ * \internal
+ * \brief Release a reference to a shared IPC event
+ *
+ * \param[in] event  Shared event to release (freed with its last reference)
+ */
+void
+pcmk__ipc_free_shared_event(pcmk__ipc_shared_event_t *event)
+{
+    if (event == NULL) {
+        return;
+    }
+    CRM_LOG_ASSERT(event->refcount > 0);
+    if (--(event->refcount) == 0) {
+        free(event->payload);
+        free(event);
+    }
+}
+
+/*!
+ * \internal
+ * \brief Queue a shared event for an IPC client and flush its event queue
+ *
+ * Unlike pcmk__ipc_send_iov(), this does not copy the message payload; only a
+ * small per-client header is allocated.
+ *
+ * \param[in,out] c      Client to send event to
+ * \param[in]     event  Shared event to send
+ * \param[in]     flags  Bitmask of crm_ipc_flags (crm_ipc_server_event is
+ *                       implied, and crm_ipc_server_free is ignored)
+ *
+ * \return Standard Pacemaker return code
+ */
+int
+pcmk__ipc_send_shared_event(pcmk__client_t *c, pcmk__ipc_shared_event_t *event,
+                            uint32_t flags)
+{
+    struct iovec *iov = NULL;
+    struct crm_ipc_response_header *header = NULL;
+    int rc = pcmk_rc_ok;
+
+    if ((c == NULL) || (event == NULL)) {
+        return EINVAL;
+    }
+
+    header = malloc(sizeof(struct crm_ipc_response_header));
+    if (header == NULL) {
+        return errno;
+    }
+    memcpy(header, &(event->header), sizeof(struct crm_ipc_response_header));
+    header->flags |= (flags & ~crm_ipc_server_free) | crm_ipc_server_event
+                     | crm_ipc_binary_ok;
+    header->qb.id = next_event_id++;
+
+    iov = pcmk__new_ipc_event();
+    iov[0].iov_base = header;
+    iov[0].iov_len = hdr_offset;
+    iov[1].iov_base = event->payload;
+    iov[1].iov_len = event->payload_len;
+
+    crm_trace("Sending shared event to %p[%d]", c->ipcs, c->pid);
+    add_event(c, iov, event);
+
+    rc = crm_ipcs_flush_events(c);
+    if ((rc == EPIPE) || (rc == ENOTCONN)) {
+        crm_trace("Client %p disconnected", c->ipcs);
+    }
+    return rc;
+}
+
 void
 pcmk__ipc_send_ack_as(const char *function, int line, pcmk__client_t *c,
                       uint32_t request, uint32_t flags, const char *tag)
@@ -1101,8 +1311,47 @@ struct crm_ipc_s {
 
     qb_ipcc_connection_t *ipc;
 
+    bool accept_binary; // Whether we can decode binary-encoded messages
+    bool server_binary; // Whether server can decode binary-encoded messages
 };
 
+/*!
+ * \internal
+ * \brief Let the server know that this client can decode binary messages
+ *
+ * Once the server has seen a request from a client using this, it may send
+ * replies and events to it in compact binary form rather than XML text, so
+ * any dispatch function for the connection must use pcmk__xml_from_message()
+ * rather than string2xml() to parse messages.
+ *
+ * \param[in,out] client  IPC connection to modify
+ */
+void
+pcmk__ipc_accept_binary(crm_ipc_t *client)
+{
+    if (client != NULL) {
+        client->accept_binary = TRUE;
+    }
+}
+
+/*!
+ * \internal
+ * \brief Remember whether the server has advertised binary message support
+ *
+ * \param[in,out] client  IPC connection whose buffer has a new message
+ */
+static inline void
+check_server_binary(crm_ipc_t *client)
+{
+    struct crm_ipc_response_header *header = (void *) client->buffer;
+
+    if (!client->server_binary && is_set(header->flags, crm_ipc_binary_ok)) {
+        crm_trace("%s IPC server accepts binary-encoded messages",
+                  client->name);
+        client->server_binary = TRUE;
+    }
+}
+
 static unsigned int
 pick_ipc_buffer(unsigned int max)
 {
@@ -1396,6 +1645,7 @@ crm_ipc_read(crm_ipc_t * client)
                     header->version, PCMK_IPC_VERSION);
             return -EBADMSG;
         }
+        check_server_binary(client);
 
         crm_trace("Received %s event %d, size=%u, rc=%d, text: %.100s",
                   client->name, header->qb.id, header->qb.size, client->msg_size,
@@ -1472,13 +1722,15 @@ internal_ipc_get_reply(crm_ipc_t *client, int request_id, int ms_timeout,
                 /* Got it */
                 break;
             } else if (hdr->qb.id < request_id) {
-                xmlNode *bad = string2xml(crm_ipc_buffer(client));
+                xmlNode *bad = pcmk__xml_from_message(crm_ipc_buffer(client),
+                                                      hdr->size_uncompressed);
 
                 crm_err("Discarding old reply %d (need %d)", hdr->qb.id, request_id);
                 crm_log_xml_notice(bad, "OldIpcReply");
 
             } else {
-                xmlNode *bad = string2xml(crm_ipc_buffer(client));
+                xmlNode *bad = pcmk__xml_from_message(crm_ipc_buffer(client),
+                                                      hdr->size_uncompressed);
 
                 crm_err("Discarding newer reply %d (need %d)", hdr->qb.id, request_id);
                 crm_log_xml_notice(bad, "ImpossibleReply");
@@ -1557,7 +1809,8 @@ crm_ipc_send(crm_ipc_t * client, xmlNode * message, enum crm_ipc_flags flags, in
 
     id++;
     CRM_LOG_ASSERT(id != 0); /* Crude wrap-around detection */
-    rc = pcmk__ipc_prepare_iov(id, message, client->max_buf_size, &iov, &bytes);
+    rc = prepare_iov(id, message, client->max_buf_size, client->server_binary,
+                     &iov, &bytes);
     if (rc != pcmk_rc_ok) {
         crm_warn("Couldn't prepare IPC request to %s: %s " CRM_XS " rc=%d",
                  client->name, pcmk_rc_str(rc), rc);
@@ -1566,6 +1819,9 @@ crm_ipc_send(crm_ipc_t * client, xmlNode * message, enum crm_ipc_flags flags, in
 
     header = iov[0].iov_base;
     header->flags |= flags;
+    if (client->accept_binary) {
+        header->flags |= crm_ipc_binary_ok;
+    }
 
     if(is_set(flags, crm_ipc_proxied)) {
         /* Don't look for a synchronous response */
@@ -1637,9 +1893,11 @@ crm_ipc_send(crm_ipc_t * client, xmlNode * message, enum crm_ipc_flags flags, in
         crm_trace("Received %d-byte reply %d to %s IPC %d: %.100s",
                   rc, hdr->qb.id, client->name, header->qb.id,
                   crm_ipc_buffer(client));
+        check_server_binary(client);
 
         if (reply) {
-            *reply = string2xml(crm_ipc_buffer(client));
+            *reply = pcmk__xml_from_message(crm_ipc_buffer(client),
+                                            hdr->size_uncompressed);
         }
 
     } else {
@@ -527,47 +527,50 @@ pcmk__add_word(char *list, const char *word)
 
 /*!
  * \internal
- * \brief Compress data
+ * \brief Get buffer size guaranteed to hold the compressed form of some data
  *
- * \param[in]  data        Data to compress
- * \param[in]  length      Number of characters of data to compress
- * \param[in]  max         Maximum size of compressed data (or 0 to estimate)
- * \param[out] result      Where to store newly allocated compressed result
- * \param[out] result_len  Where to store actual compressed length of result
+ * \param[in] length  Number of characters of data to be compressed
+ *
+ * \return Buffer size sufficient for any compression result
+ */
+unsigned int
+pcmk__compress_bound(unsigned int length)
+{
+    return (length * 1.01) + 601; // Per bzip2 documentation
+}
+
+/*!
+ * \internal
+ * \brief Compress data into a caller-supplied buffer
+ *
+ * \param[in]     data        Data to compress
+ * \param[in]     length      Number of characters of data to compress
+ * \param[out]    buffer      Where to store compressed result
+ * \param[in,out] buffer_len  On input, size of \p buffer; on output, actual
+ *                            compressed length
  *
  * \return Standard Pacemaker return code
+ * \note This allows callers to compress straight into a message allocation,
+ *       without intermediate copies of the (possibly large) input or output.
  */
 int
-pcmk__compress(const char *data, unsigned int length, unsigned int max,
-               char **result, unsigned int *result_len)
+pcmk__compress_to_buffer(const char *data, unsigned int length, char *buffer,
+                         unsigned int *buffer_len)
 {
     int rc;
-    char *compressed = NULL;
-    char *uncompressed = strdup(data);
 #ifdef CLOCK_MONOTONIC
     struct timespec after_t;
     struct timespec before_t;
-#endif
-
-    if (max == 0) {
-        max = (length * 1.01) + 601; // Size guaranteed to hold result
-    }
 
-#ifdef CLOCK_MONOTONIC
     clock_gettime(CLOCK_MONOTONIC, &before_t);
 #endif
 
-    compressed = calloc((size_t) max, sizeof(char));
-    CRM_ASSERT(compressed);
-
-    *result_len = max;
-    rc = BZ2_bzBuffToBuffCompress(compressed, result_len, uncompressed, length,
+    // bzip2 does not modify its input, despite the non-const argument
+    rc = BZ2_bzBuffToBuffCompress(buffer, buffer_len, (char *) data, length,
                                   CRM_BZ2_BLOCKS, 0, CRM_BZ2_WORK);
-    free(uncompressed);
     if (rc != BZ_OK) {
         crm_err("Compression of %d bytes failed: %s " CRM_XS " bzerror=%d",
                 length, bz2_strerror(rc), rc);
-        free(compressed);
         return pcmk_rc_error;
     }
 
@@ -575,13 +578,57 @@ pcmk__compress(const char *data, unsigned int length, unsigned int max,
     clock_gettime(CLOCK_MONOTONIC, &after_t);
 
     crm_trace("Compressed %d bytes into %d (ratio %d:1) in %.0fms",
-             length, *result_len, length / (*result_len),
+             length, *buffer_len, length / (*buffer_len),
              (after_t.tv_sec - before_t.tv_sec) * 1000 +
              (after_t.tv_nsec - before_t.tv_nsec) / 1e6);
 #else
     crm_trace("Compressed %d bytes into %d (ratio %d:1)",
-             length, *result_len, length / (*result_len));
+             length, *buffer_len, length / (*buffer_len));
 #endif
+    return pcmk_rc_ok;
+}
+
+/*!
+ * \internal
+ * \brief Compress data
+ *
+ * \param[in]  data        Data to compress
+ * \param[in]  length      Number of characters of data to compress
+ * \param[in]  max         Maximum size of compressed data (or 0 to estimate)
+ * \param[out] result      Where to store newly allocated compressed result
+ * \param[out] result_len  Where to store actual compressed length of result
+ *
+ * \return Standard Pacemaker return code
+ */
+int
+pcmk__compress(const char *data, unsigned int length, unsigned int max,
+               char **result, unsigned int *result_len)
+{
+    int rc;
+    char *compressed = NULL;
+
+    if (max == 0) {
+        max = pcmk__compress_bound(length);
+    }
+
+    compressed = calloc((size_t) max, sizeof(char));
+    CRM_ASSERT(compressed);
+
+    *result_len = max;
+    rc = pcmk__compress_to_buffer(data, length, compressed, result_len);
+    if (rc != pcmk_rc_ok) {
+        free(compressed);
+        return rc;
+    }
+
+    // Don't hold on to the unused part of the buffer
+    if (*result_len < max) {
+        char *shrunk = realloc(compressed, *result_len);
+
+        if (shrunk != NULL) {
+            compressed = shrunk;
+        }
+    }
 
     *result = compressed;
     return pcmk_rc_ok;
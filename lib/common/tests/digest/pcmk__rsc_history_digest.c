@@ -0,0 +1,74 @@
+#include <glib.h>
+
+#include <crm_internal.h>
+#include <crm/msg_xml.h>
+
+#define RSC_XML(origin, first_op, second_op)                                \
+    "<" XML_LRM_TAG_RESOURCE " " XML_ATTR_ID "=\"rsc1\" "                   \
+        XML_ATTR_TYPE "=\"Dummy\" " XML_AGENT_ATTR_CLASS "=\"ocf\" "        \
+        XML_AGENT_ATTR_PROVIDER "=\"pacemaker\">"                           \
+    first_op(origin) second_op(origin)                                      \
+    "</" XML_LRM_TAG_RESOURCE ">"
+
+#define START_OP(origin)                                                    \
+    "<" XML_LRM_TAG_RSC_OP " " XML_ATTR_ID "=\"rsc1_last_0\" "              \
+        XML_LRM_ATTR_TASK "=\"start\" " XML_LRM_ATTR_RC "=\"0\" "           \
+        XML_LRM_ATTR_CALLID "=\"5\" " XML_ATTR_ORIGIN "=\"" origin "\"/>"
+
+#define MONITOR_OP(origin)                                                  \
+    "<" XML_LRM_TAG_RSC_OP " " XML_ATTR_ID "=\"rsc1_monitor_10000\" "       \
+        XML_LRM_ATTR_TASK "=\"monitor\" " XML_LRM_ATTR_RC "=\"0\" "         \
+        XML_LRM_ATTR_CALLID "=\"6\" " XML_ATTR_ORIGIN "=\"" origin "\"/>"
+
+#define FAILED_MONITOR_OP(origin)                                           \
+    "<" XML_LRM_TAG_RSC_OP " " XML_ATTR_ID "=\"rsc1_monitor_10000\" "       \
+        XML_LRM_ATTR_TASK "=\"monitor\" " XML_LRM_ATTR_RC "=\"7\" "         \
+        XML_LRM_ATTR_CALLID "=\"6\" " XML_ATTR_ORIGIN "=\"" origin "\"/>"
+
+static char *
+digest_of(const char *text)
+{
+    xmlNode *xml = string2xml(text);
+    char *digest = NULL;
+
+    g_assert(xml != NULL);
+    digest = pcmk__rsc_history_digest(xml);
+    g_assert(digest != NULL);
+    free_xml(xml);
+    return digest;
+}
+
+static void
+rebuilt_matches_cib(void) {
+    // As written to the CIB as results arrived, versus rebuilt for a join
+    char *cib = digest_of(RSC_XML("do_update_resource", START_OP,
+                                  MONITOR_OP));
+    char *rebuilt = digest_of(RSC_XML("build_active_RAs", MONITOR_OP,
+                                      START_OP));
+
+    g_assert_cmpstr(cib, ==, rebuilt);
+    free(cib);
+    free(rebuilt);
+}
+
+static void
+changed_result_differs(void) {
+    char *cib = digest_of(RSC_XML("do_update_resource", START_OP,
+                                  MONITOR_OP));
+    char *rebuilt = digest_of(RSC_XML("build_active_RAs", START_OP,
+                                      FAILED_MONITOR_OP));
+
+    g_assert_cmpstr(cib, !=, rebuilt);
+    free(cib);
+    free(rebuilt);
+}
+
+int main(int argc, char **argv) {
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/common/digest/rsc_history/rebuilt", rebuilt_matches_cib);
+    g_test_add_func("/common/digest/rsc_history/changed",
+                    changed_result_differs);
+
+    return g_test_run();
+}
@@ -0,0 +1,53 @@
+#include <glib.h>
+
+#include <crm_internal.h>
+#include <crm/msg_xml.h>
+
+// Find or create an entry, as the controller does when queuing history
+static xmlNode *
+queue_entry(xmlNode *parent, const char *name, const char *id)
+{
+    xmlNode *entry = find_entity(parent, name, id);
+
+    if (entry == NULL) {
+        entry = create_xml_node(parent, name);
+        crm_xml_add(entry, XML_ATTR_ID, id);
+    }
+    return entry;
+}
+
+static void
+ids_differing_in_case(void) {
+    xmlNode *resources = create_xml_node(NULL, XML_LRM_TAG_RESOURCES);
+    xmlNode *lower = queue_entry(resources, XML_LRM_TAG_RESOURCE, "db");
+    xmlNode *upper = queue_entry(resources, XML_LRM_TAG_RESOURCE, "DB");
+
+    g_assert(lower != upper);
+    g_assert_cmpint(xmlChildElementCount(resources), ==, 2);
+    g_assert(queue_entry(resources, XML_LRM_TAG_RESOURCE, "db") == lower);
+    g_assert(queue_entry(resources, XML_LRM_TAG_RESOURCE, "DB") == upper);
+    g_assert_cmpstr(ID(lower), ==, "db");
+    g_assert_cmpstr(ID(upper), ==, "DB");
+
+    free_xml(resources);
+}
+
+static void
+no_id(void) {
+    xmlNode *lrm = create_xml_node(NULL, XML_CIB_TAG_LRM);
+    xmlNode *resources = queue_entry(lrm, XML_LRM_TAG_RESOURCES, NULL);
+
+    g_assert(queue_entry(lrm, XML_LRM_TAG_RESOURCES, NULL) == resources);
+    g_assert_cmpint(xmlChildElementCount(lrm), ==, 1);
+
+    free_xml(lrm);
+}
+
+int main(int argc, char **argv) {
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/common/xml/find_entity/case", ids_differing_in_case);
+    g_test_add_func("/common/xml/find_entity/no_id", no_id);
+
+    return g_test_run();
+}
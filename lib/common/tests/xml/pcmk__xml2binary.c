@@ -0,0 +1,88 @@
+#include <glib.h>
+
+#include <crm_internal.h>
+#include <crm/msg_xml.h>
+#include <crm/common/xml_internal.h>
+
+static void
+assert_round_trip(const char *text) {
+    xmlNode *xml = string2xml(text);
+    xmlNode *decoded = NULL;
+    char *encoded = NULL;
+    size_t length = 0;
+    char *before = NULL;
+    char *after = NULL;
+
+    g_assert(xml != NULL);
+    g_assert(pcmk__xml2binary(xml, &encoded, &length) == pcmk_rc_ok);
+    g_assert(pcmk__xml_is_binary(encoded, length));
+
+    decoded = pcmk__xml_from_message(encoded, length);
+    g_assert(decoded != NULL);
+
+    before = dump_xml_unformatted(xml);
+    after = dump_xml_unformatted(decoded);
+    g_assert_cmpstr(before, ==, after);
+
+    free(before);
+    free(after);
+    free(encoded);
+    free_xml(decoded);
+    free_xml(xml);
+}
+
+static void
+interned_names(void) {
+    assert_round_trip("<" XML_GRAPH_TAG_RSC_OP " " XML_ATTR_ID "=\"1\" "
+                      XML_LRM_ATTR_TASK "=\"monitor\"/>");
+}
+
+static void
+literal_names(void) {
+    assert_round_trip("<not_interned some_attribute=\"value\">"
+                      "<child other=\"\"/></not_interned>");
+}
+
+static void
+nested_with_comment(void) {
+    assert_round_trip("<" XML_TAG_CIB "><!-- note -->"
+                      "<" XML_CIB_TAG_CONFIGURATION "><" XML_CIB_TAG_NODES "/>"
+                      "</" XML_CIB_TAG_CONFIGURATION "></" XML_TAG_CIB ">");
+}
+
+static void
+text_fallback(void) {
+    const char *text = "<" XML_TAG_CIB "/>";
+    xmlNode *xml = NULL;
+
+    g_assert(!pcmk__xml_is_binary(text, strlen(text) + 1));
+    xml = pcmk__xml_from_message(text, strlen(text) + 1);
+    g_assert(xml != NULL);
+    g_assert_cmpstr((const char *) xml->name, ==, XML_TAG_CIB);
+    free_xml(xml);
+}
+
+static void
+truncated_input(void) {
+    xmlNode *xml = string2xml("<" XML_TAG_CIB " " XML_ATTR_ID "=\"x\"/>");
+    char *encoded = NULL;
+    size_t length = 0;
+
+    g_assert(pcmk__xml2binary(xml, &encoded, &length) == pcmk_rc_ok);
+    g_assert(pcmk__binary2xml(encoded, length - 3) == NULL);
+
+    free(encoded);
+    free_xml(xml);
+}
+
+int main(int argc, char **argv) {
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/common/xml/binary/interned", interned_names);
+    g_test_add_func("/common/xml/binary/literal", literal_names);
+    g_test_add_func("/common/xml/binary/comment", nested_with_comment);
+    g_test_add_func("/common/xml/binary/text_fallback", text_fallback);
+    g_test_add_func("/common/xml/binary/truncated", truncated_input);
+
+    return g_test_run();
+}
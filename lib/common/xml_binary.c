@@ -0,0 +1,463 @@
+/*
+ * Copyright 2020 the Pacemaker project contributors
+ *
+ * The version control history for this file may have further details.
+ *
+ * This source code is licensed under the GNU Lesser General Public License
+ * version 2.1 or later (LGPLv2.1+) WITHOUT ANY WARRANTY.
+ */
+
+#include <crm_internal.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <crm/crm.h>
+#include <crm/msg_xml.h>
+#include <crm/lrmd.h>
+#include <crm/common/xml.h>
+#include <crm/common/xml_internal.h>
+#include "crmcommon_private.h"
+
+/*
+ * Compact binary encoding of XML messages
+ *
+ * This is used as an optional alternative to XML text for high-volume internal
+ * messages (such as executor results and scheduler requests) between peers
+ * that have both advertised support for it (see crm_ipc_binary_ok).
+ *
+ * The encoding is:
+ *
+ *   message   := MAGIC node NUL
+ *   node      := NODE_ELEMENT name nattrs attr{nattrs} nchildren node{nchildren}
+ *              | NODE_COMMENT literal
+ *              | NODE_TEXT literal
+ *   attr      := name literal
+ *   name      := varint(2 * id + 1)                  (interned name)
+ *              | varint(2 * length) bytes NUL         (literal name)
+ *   literal   := varint(length) bytes NUL
+ *
+ * Varints are unsigned LEB128. Strings keep their terminating NUL so that the
+ * decoder can use them in place, and the trailing NUL lets the message pass
+ * the same sanity checks as XML text.
+ */
+
+#define BINARY_MAGIC        "\001PB1"
+#define BINARY_MAGIC_LEN    4
+
+enum binary_node_type {
+    binary_node_element = 1,
+    binary_node_comment = 2,
+    binary_node_text    = 3,
+};
+
+/* Interned element and attribute names
+ *
+ * Both ends of a connection must agree on this table, so it may only ever be
+ * appended to. If an entry must change, bump the version in BINARY_MAGIC.
+ */
+static const char *const interned_names[] = {
+    // Generic message fields
+    F_TYPE, F_ORIG, F_SUBTYPE, F_SEQ, F_XML_TAGNAME,
+    F_CRM_DATA, F_CRM_TASK, F_CRM_HOST_TO, F_CRM_SYS_TO, F_CRM_SYS_FROM,
+    F_CRM_ORIGIN, F_CRM_USER, F_CRM_REFERENCE, F_CRM_VERSION,
+    F_CRM_TGRAPH, F_CRM_TGRAPH_INPUT,
+
+    // Executor API
+    T_LRMD, T_LRMD_REPLY, T_LRMD_NOTIFY, T_LRMD_RSC_OP,
+    F_LRMD_OPERATION, F_LRMD_CLIENTNAME, F_LRMD_CLIENTID,
+    F_LRMD_CALLBACK_TOKEN, F_LRMD_CALLID, F_LRMD_CALLOPTS, F_LRMD_CALLDATA,
+    F_LRMD_RC, F_LRMD_EXEC_RC, F_LRMD_OP_STATUS, F_LRMD_TIMEOUT,
+    F_LRMD_CLASS, F_LRMD_PROVIDER, F_LRMD_TYPE, F_LRMD_ORIGIN,
+    F_LRMD_RSC_RUN_TIME, F_LRMD_RSC_RCCHANGE_TIME, F_LRMD_RSC_EXEC_TIME,
+    F_LRMD_RSC_QUEUE_TIME, F_LRMD_RSC_ID, F_LRMD_RSC_ACTION,
+    F_LRMD_RSC_USERDATA_STR, F_LRMD_RSC_OUTPUT, F_LRMD_RSC_EXIT_REASON,
+    F_LRMD_RSC_START_DELAY, F_LRMD_RSC_INTERVAL, F_LRMD_RSC_DELETED,
+    F_LRMD_RSC,
+
+    // Attribute manager API
+    PCMK__XA_ATTR_DAMPENING, PCMK__XA_ATTR_FORCE, PCMK__XA_ATTR_IS_PRIVATE,
+    PCMK__XA_ATTR_IS_REMOTE, PCMK__XA_ATTR_NAME, PCMK__XA_ATTR_NODE_ID,
+    PCMK__XA_ATTR_NODE_NAME, PCMK__XA_ATTR_PATTERN, PCMK__XA_ATTR_SECTION,
+    PCMK__XA_ATTR_SET, PCMK__XA_ATTR_USER, PCMK__XA_ATTR_UUID,
+    PCMK__XA_ATTR_VALUE, PCMK__XA_ATTR_VERSION, PCMK__XA_ATTR_WRITER,
+    PCMK__XA_TASK,
+
+    // Common CIB content
+    XML_ATTR_ID, XML_ATTR_TYPE, XML_ATTR_UNAME, XML_ATTR_ORIGIN,
+    XML_ATTR_CRM_VERSION, XML_AGENT_ATTR_CLASS, XML_AGENT_ATTR_PROVIDER,
+    XML_NVPAIR_ATTR_NAME, XML_NVPAIR_ATTR_VALUE, XML_CIB_TAG_NVPAIR,
+    XML_TAG_ATTRS, XML_CIB_TAG_STATE, XML_LRM_TAG_RESOURCES,
+    XML_LRM_TAG_RESOURCE, XML_LRM_TAG_RSC_OP, XML_LRM_ATTR_INTERVAL,
+    XML_LRM_ATTR_TASK, XML_LRM_ATTR_TASK_KEY, XML_LRM_ATTR_TARGET,
+    XML_LRM_ATTR_TARGET_UUID, XML_LRM_ATTR_OPSTATUS, XML_LRM_ATTR_RC,
+    XML_LRM_ATTR_CALLID, XML_LRM_ATTR_OP_DIGEST, XML_LRM_ATTR_EXIT_REASON,
+    XML_RSC_OP_LAST_CHANGE, XML_RSC_OP_T_EXEC, XML_RSC_OP_T_QUEUE,
+    XML_ATTR_TRANSITION_MAGIC, XML_ATTR_TRANSITION_KEY,
+};
+
+#define N_INTERNED (sizeof(interned_names) / sizeof(interned_names[0]))
+
+// Growable output buffer
+typedef struct binary_buf_s {
+    char *data;
+    size_t len;
+    size_t alloc;
+} binary_buf_t;
+
+static GHashTable *interned_ids = NULL;
+
+static GHashTable *
+name_table(void)
+{
+    if (interned_ids == NULL) {
+        interned_ids = g_hash_table_new(g_str_hash, g_str_equal);
+        for (size_t lpc = 0; lpc < N_INTERNED; lpc++) {
+            // Store id + 1 so that a lookup miss (NULL) is distinguishable
+            g_hash_table_insert(interned_ids, (gpointer) interned_names[lpc],
+                                GSIZE_TO_POINTER(lpc + 1));
+        }
+    }
+    return interned_ids;
+}
+
+static void
+buf_reserve(binary_buf_t *buf, size_t needed)
+{
+    if ((buf->len + needed) > buf->alloc) {
+        buf->alloc = QB_MAX(2 * buf->alloc, buf->len + needed + 256);
+        buf->data = realloc_safe(buf->data, buf->alloc);
+    }
+}
+
+static void
+buf_add_varint(binary_buf_t *buf, uint64_t value)
+{
+    buf_reserve(buf, 10);
+    do {
+        uint8_t byte = value & 0x7f;
+
+        value >>= 7;
+        if (value != 0) {
+            byte |= 0x80;
+        }
+        buf->data[buf->len++] = (char) byte;
+    } while (value != 0);
+}
+
+static void
+buf_add_bytes(binary_buf_t *buf, const char *bytes, size_t len)
+{
+    buf_reserve(buf, len + 1);
+    memcpy(buf->data + buf->len, bytes, len);
+    buf->len += len;
+    buf->data[buf->len++] = '\0';
+}
+
+static void
+buf_add_literal(binary_buf_t *buf, const char *text)
+{
+    size_t len = (text == NULL)? 0 : strlen(text);
+
+    buf_add_varint(buf, len);
+    buf_add_bytes(buf, (text == NULL)? "" : text, len);
+}
+
+static void
+buf_add_name(binary_buf_t *buf, const char *name)
+{
+    gpointer id = g_hash_table_lookup(name_table(), name);
+
+    if (id != NULL) {
+        buf_add_varint(buf, 2 * (GPOINTER_TO_SIZE(id) - 1) + 1);
+    } else {
+        size_t len = strlen(name);
+
+        buf_add_varint(buf, 2 * len);
+        buf_add_bytes(buf, name, len);
+    }
+}
+
+static int
+encode_node(binary_buf_t *buf, xmlNode *xml)
+{
+    uint64_t count = 0;
+
+    switch (xml->type) {
+        case XML_ELEMENT_NODE:
+            break;
+
+        case XML_COMMENT_NODE:
+            buf_add_varint(buf, binary_node_comment);
+            buf_add_literal(buf, (const char *) xml->content);
+            return pcmk_rc_ok;
+
+        case XML_TEXT_NODE:
+            buf_add_varint(buf, binary_node_text);
+            buf_add_literal(buf, (const char *) xml->content);
+            return pcmk_rc_ok;
+
+        default:
+            // Anything else (CDATA, PIs, etc.) must be sent as XML text
+            return EPROTONOSUPPORT;
+    }
+
+    if (xml->ns != NULL) {
+        return EPROTONOSUPPORT;
+    }
+
+    buf_add_varint(buf, binary_node_element);
+    buf_add_name(buf, (const char *) xml->name);
+
+    for (xmlAttr *a = pcmk__first_xml_attr(xml); a != NULL; a = a->next) {
+        count++;
+    }
+    buf_add_varint(buf, count);
+    for (xmlAttr *a = pcmk__first_xml_attr(xml); a != NULL; a = a->next) {
+        if (a->ns != NULL) {
+            return EPROTONOSUPPORT;
+        }
+        buf_add_name(buf, (const char *) a->name);
+        buf_add_literal(buf, pcmk__xml_attr_value(a));
+    }
+
+    count = 0;
+    for (xmlNode *child = xml->children; child != NULL; child = child->next) {
+        count++;
+    }
+    buf_add_varint(buf, count);
+    for (xmlNode *child = xml->children; child != NULL; child = child->next) {
+        int rc = encode_node(buf, child);
+
+        if (rc != pcmk_rc_ok) {
+            return rc;
+        }
+    }
+    return pcmk_rc_ok;
+}
+
+/*!
+ * \internal
+ * \brief Encode an XML message in compact binary form
+ *
+ * \param[in]  xml     XML to encode
+ * \param[out] result  Where to store newly allocated encoding
+ * \param[out] length  Where to store size of \p result in bytes
+ *
+ * \return Standard Pacemaker return code
+ * \note A return code of EPROTONOSUPPORT means the XML uses features that have
+ *       no binary representation, and should be sent as text instead.
+ */
+int
+pcmk__xml2binary(xmlNode *xml, char **result, size_t *length)
+{
+    binary_buf_t buf = { NULL, 0, 0 };
+    int rc = pcmk_rc_ok;
+
+    if ((xml == NULL) || (result == NULL) || (length == NULL)) {
+        return EINVAL;
+    }
+
+    buf_reserve(&buf, 1024);
+    memcpy(buf.data, BINARY_MAGIC, BINARY_MAGIC_LEN);
+    buf.len = BINARY_MAGIC_LEN;
+
+    rc = encode_node(&buf, xml);
+    if (rc != pcmk_rc_ok) {
+        free(buf.data);
+        return rc;
+    }
+    buf_reserve(&buf, 1);
+    buf.data[buf.len++] = '\0';
+
+    *result = buf.data;
+    *length = buf.len;
+    return pcmk_rc_ok;
+}
+
+// Read-only cursor into an encoded message
+typedef struct binary_cursor_s {
+    const char *data;
+    size_t len;
+    size_t offset;
+} binary_cursor_t;
+
+static bool
+read_varint(binary_cursor_t *cur, uint64_t *value)
+{
+    *value = 0;
+    for (int shift = 0; (shift < 64) && (cur->offset < cur->len); shift += 7) {
+        uint8_t byte = (uint8_t) cur->data[cur->offset++];
+
+        *value |= ((uint64_t) (byte & 0x7f)) << shift;
+        if ((byte & 0x80) == 0) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static const char *
+read_bytes(binary_cursor_t *cur, uint64_t len)
+{
+    const char *bytes = cur->data + cur->offset;
+
+    if ((len >= (cur->len - cur->offset)) || (bytes[len] != '\0')) {
+        return NULL;
+    }
+    cur->offset += len + 1;
+    return bytes;
+}
+
+static const char *
+read_literal(binary_cursor_t *cur)
+{
+    uint64_t len = 0;
+
+    return read_varint(cur, &len)? read_bytes(cur, len) : NULL;
+}
+
+static const char *
+read_name(binary_cursor_t *cur)
+{
+    uint64_t value = 0;
+
+    if (!read_varint(cur, &value)) {
+        return NULL;
+    }
+    if (value & 1) {
+        value >>= 1;
+        return (value < N_INTERNED)? interned_names[value] : NULL;
+    }
+    return read_bytes(cur, value >> 1);
+}
+
+static bool
+decode_node(binary_cursor_t *cur, xmlNode *parent, xmlNode **result)
+{
+    uint64_t type = 0;
+    uint64_t count = 0;
+    const char *name = NULL;
+    xmlNode *xml = NULL;
+
+    if (!read_varint(cur, &type)) {
+        return FALSE;
+    }
+
+    if ((type == binary_node_comment) || (type == binary_node_text)) {
+        const char *content = read_literal(cur);
+
+        if ((content == NULL) || (parent == NULL)) {
+            return FALSE;
+        }
+        if (type == binary_node_comment) {
+            xml = xmlNewDocComment(parent->doc, (pcmkXmlStr) content);
+        } else {
+            xml = xmlNewDocText(parent->doc, (pcmkXmlStr) content);
+        }
+        xmlAddChild(parent, xml);
+        return TRUE;
+
+    } else if (type != binary_node_element) {
+        return FALSE;
+    }
+
+    name = read_name(cur);
+    if ((name == NULL) || !read_varint(cur, &count)) {
+        return FALSE;
+    }
+    xml = create_xml_node(parent, name);
+    if (xml == NULL) {
+        return FALSE;
+    }
+    if (result != NULL) {
+        *result = xml;
+    }
+
+    for (; count > 0; count--) {
+        const char *attr = read_name(cur);
+        const char *value = (attr == NULL)? NULL : read_literal(cur);
+
+        if (value == NULL) {
+            return FALSE;
+        }
+        // Newly created documents are not tracked, so no need for crm_xml_add()
+        xmlSetProp(xml, (pcmkXmlStr) attr, (pcmkXmlStr) value);
+    }
+
+    if (!read_varint(cur, &count)) {
+        return FALSE;
+    }
+    for (; count > 0; count--) {
+        if (!decode_node(cur, xml, NULL)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*!
+ * \internal
+ * \brief Check whether a message buffer holds binary-encoded XML
+ *
+ * \param[in] data    Message buffer
+ * \param[in] length  Size of \p data in bytes
+ *
+ * \return TRUE if \p data starts with the binary encoding's magic prefix
+ */
+bool
+pcmk__xml_is_binary(const char *data, size_t length)
+{
+    return (data != NULL) && (length >= BINARY_MAGIC_LEN)
+           && (memcmp(data, BINARY_MAGIC, BINARY_MAGIC_LEN) == 0);
+}
+
+/*!
+ * \internal
+ * \brief Decode binary-encoded XML
+ *
+ * \param[in] data    Encoded message
+ * \param[in] length  Size of \p data in bytes
+ *
+ * \return Newly allocated XML on success, otherwise NULL
+ * \note The caller is responsible for freeing the result with free_xml().
+ */
+xmlNode *
+pcmk__binary2xml(const char *data, size_t length)
+{
+    binary_cursor_t cur = { data, length, BINARY_MAGIC_LEN };
+    xmlNode *xml = NULL;
+
+    if (!pcmk__xml_is_binary(data, length)) {
+        return NULL;
+    }
+    if (!decode_node(&cur, NULL, &xml)) {
+        crm_err("Could not decode %llu-byte binary message "
+                CRM_XS " offset=%llu", (unsigned long long) length,
+                (unsigned long long) cur.offset);
+        free_xml(xml);
+        return NULL;
+    }
+    return xml;
+}
+
+/*!
+ * \internal
+ * \brief Parse a received message, whether XML text or binary-encoded
+ *
+ * \param[in] data    Message buffer
+ * \param[in] length  Size of \p data in bytes (including terminator)
+ *
+ * \return Newly allocated XML on success, otherwise NULL
+ * \note The caller is responsible for freeing the result with free_xml().
+ */
+xmlNode *
+pcmk__xml_from_message(const char *data, size_t length)
+{
+    if (pcmk__xml_is_binary(data, length)) {
+        return pcmk__binary2xml(data, length);
+    }
+    return string2xml(data);
+}
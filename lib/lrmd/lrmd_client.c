@@ -28,7 +28,9 @@
 #include <crm/services.h>
 #include <crm/common/mainloop.h>
 #include <crm/common/ipcs_internal.h>
+#include <crm/common/ipc_internal.h>
 #include <crm/common/remote_internal.h>
+#include <crm/common/xml_internal.h>
 #include <crm/msg_xml.h>
 
 #include <crm/stonith-ng.h>
@@ -333,7 +335,7 @@ lrmd_ipc_dispatch(const char *buffer, ssize_t length, gpointer userdata)
         return 1;
     }
 
-    msg = string2xml(buffer);
+    msg = pcmk__xml_from_message(buffer, length);
     rc = lrmd_dispatch_internal(lrmd, msg);
     free_xml(msg);
     return rc;
@@ -474,10 +476,12 @@ lrmd_dispatch(lrmd_t * lrmd)
     switch (private->type) {
         case PCMK__CLIENT_IPC:
             while (crm_ipc_ready(private->ipc)) {
-                if (crm_ipc_read(private->ipc) > 0) {
+                long length = crm_ipc_read(private->ipc);
+
+                if (length > 0) {
                     const char *msg = crm_ipc_buffer(private->ipc);
 
-                    lrmd_ipc_dispatch(msg, strlen(msg), lrmd);
+                    lrmd_ipc_dispatch(msg, length, lrmd);
                 }
             }
             break;
@@ -1032,6 +1036,9 @@ lrmd_ipc_connect(lrmd_t * lrmd, int *fd)
         native->ipc = mainloop_get_ipc_client(native->source);
     }
 
+    // All messages from the executor are parsed by lrmd_ipc_dispatch()
+    pcmk__ipc_accept_binary(native->ipc);
+
     if (native->ipc == NULL) {
         crm_debug("Could not connect to the executor API");
         rc = -ENOTCONN;
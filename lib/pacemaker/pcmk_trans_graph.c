@@ -16,8 +16,58 @@
 
 crm_graph_functions_t *graph_fns = NULL;
 
+/* The graph's completed and pending totals are kept up to date as synapses
+ * change state, rather than by counting every synapse each time the graph is
+ * run. Each synapse remembers which total (if any) it is counted in.
+ */
+enum synapse_tally {
+    synapse_tally_none = 0,
+    synapse_tally_pending,
+    synapse_tally_completed,
+};
+
+static enum synapse_tally
+synapse_tally(synapse_t *synapse)
+{
+    if (synapse->confirmed) {
+        return synapse_tally_completed;
+
+    } else if (synapse->failed == FALSE && synapse->executed) {
+        return synapse_tally_pending;
+    }
+    return synapse_tally_none;
+}
+
+static void
+adjust_tally(crm_graph_t *graph, enum synapse_tally tally, int change)
+{
+    switch (tally) {
+        case synapse_tally_pending:
+            graph->pending += change;
+            break;
+        case synapse_tally_completed:
+            graph->completed += change;
+            break;
+        default:
+            break;
+    }
+}
+
+// Update graph totals after a synapse may have changed state
+static void
+retally_synapse(crm_graph_t *graph, synapse_t *synapse)
+{
+    enum synapse_tally tally = synapse_tally(synapse);
+
+    if (tally != (enum synapse_tally) synapse->tally) {
+        adjust_tally(graph, (enum synapse_tally) synapse->tally, -1);
+        adjust_tally(graph, tally, 1);
+        synapse->tally = (int) tally;
+    }
+}
+
 static gboolean
-update_synapse_ready(synapse_t * synapse, int action_id)
+update_synapse_ready(crm_graph_t *graph, synapse_t * synapse, int action_id)
 {
     GListPtr lpc = NULL;
     gboolean updates = FALSE;
@@ -33,7 +83,12 @@ update_synapse_ready(synapse_t * synapse, int action_id)
 
         if (prereq->id == action_id) {
             crm_trace("Marking input %d of synapse %d confirmed", action_id, synapse->id);
-            prereq->confirmed = TRUE;
+            if (prereq->confirmed == FALSE) {
+                prereq->confirmed = TRUE;
+                if (--(synapse->pending_inputs) == 0) {
+                    g_queue_push_tail(graph->ready, synapse);
+                }
+            }
             updates = TRUE;
 
         } else if (prereq->confirmed == FALSE) {
@@ -87,27 +142,45 @@ update_synapse_confirmed(synapse_t * synapse, int action_id)
     return updates;
 }
 
+static gboolean
+update_synapse(crm_graph_t *graph, synapse_t *synapse, crm_action_t *action)
+{
+    gboolean rc = FALSE;
+
+    if (synapse->confirmed || synapse->failed) {
+        crm_trace("Synapse complete");
+
+    } else if (synapse->executed) {
+        crm_trace("Synapse executed");
+        rc = update_synapse_confirmed(synapse, action->id);
+
+    } else if (action->failed == FALSE || synapse->priority == INFINITY) {
+        rc = update_synapse_ready(graph, synapse, action->id);
+    }
+    retally_synapse(graph, synapse);
+    return rc;
+}
+
 gboolean
 update_graph(crm_graph_t * graph, crm_action_t * action)
 {
-    gboolean rc = FALSE;
     gboolean updates = FALSE;
-    GListPtr lpc = NULL;
+    GList *dependents = NULL;
 
-    for (lpc = graph->synapses; lpc != NULL; lpc = lpc->next) {
+    /* Only the synapse containing the action, and the synapses that have the
+     * action as an input, can be affected
+     */
+    if (action->synapse != NULL) {
+        updates = update_synapse(graph, action->synapse, action);
+    }
+    dependents = g_hash_table_lookup(graph->dependents,
+                                     GINT_TO_POINTER(action->id));
+    for (GList *lpc = dependents; lpc != NULL; lpc = lpc->next) {
         synapse_t *synapse = (synapse_t *) lpc->data;
 
-        if (synapse->confirmed || synapse->failed) {
-            crm_trace("Synapse complete");
-
-        } else if (synapse->executed) {
-            crm_trace("Synapse executed");
-            rc = update_synapse_confirmed(synapse, action->id);
-
-        } else if (action->failed == FALSE || synapse->priority == INFINITY) {
-            rc = update_synapse_ready(synapse, action->id);
+        if (synapse != action->synapse) {
+            updates = update_synapse(graph, synapse, action) || updates;
         }
-        updates = updates || rc;
     }
 
     if (updates) {
@@ -173,6 +246,7 @@ initiate_action(crm_graph_t * graph, crm_action_t * action)
     CRM_CHECK(id != NULL, return FALSE);
 
     action->executed = TRUE;
+    action->initiated_ms = g_get_monotonic_time() / 1000;
     if (action->type == action_type_pseudo) {
         crm_trace("Executing pseudo-event: %s (%d)", id, action->id);
         return graph_fns->pseudo(graph, action);
@@ -232,12 +306,69 @@ fire_synapse(crm_graph_t * graph, synapse_t * synapse)
     return TRUE;
 }
 
+/*!
+ * \internal
+ * \brief Count synapses in each state by checking every one
+ *
+ * \param[in,out] graph  Graph to check
+ *
+ * \return Number of failed synapses
+ * \note This is used only when a transition appears complete, to get exact
+ *       totals for the final log message (and as a safety net for the
+ *       incrementally maintained ones).
+ */
+static int
+recount_synapses(crm_graph_t *graph)
+{
+    int failed = 0;
+
+    graph->pending = 0;
+    graph->completed = 0;
+    graph->incomplete = 0;
+
+    for (GList *lpc = graph->synapses; lpc != NULL; lpc = lpc->next) {
+        synapse_t *synapse = (synapse_t *) lpc->data;
+
+        synapse->tally = (int) synapse_tally(synapse);
+        adjust_tally(graph, (enum synapse_tally) synapse->tally, 1);
+
+        if (synapse->failed) {
+            failed++;
+        } else if (!synapse->confirmed && !synapse->executed) {
+            graph->incomplete++;
+        }
+    }
+    return failed;
+}
+
+/*!
+ * \internal
+ * \brief Remove a synapse from the ready queue
+ *
+ * \param[in,out] graph  Graph that synapse is part of
+ * \param[in]     link   Synapse's link in the graph's ready queue
+ *
+ * \return Link of the next ready synapse (if any)
+ * \note Firing a synapse can confirm actions immediately, appending more
+ *       synapses to the queue, so this must be called only after the synapse
+ *       has been dealt with.
+ */
+static GList *
+remove_ready(crm_graph_t *graph, GList *link)
+{
+    GList *next = link->next;
+
+    g_queue_delete_link(graph->ready, link);
+    return next;
+}
+
 int
 run_graph(crm_graph_t * graph)
 {
     GListPtr lpc = NULL;
     int stat_log_level = LOG_DEBUG;
     int pass_result = transition_active;
+    int failed = 0;
 
     const char *status = "In-progress";
 
@@ -249,39 +380,27 @@ run_graph(crm_graph_t * graph)
     }
 
     graph->fired = 0;
-    graph->pending = 0;
     graph->skipped = 0;
-    graph->completed = 0;
     graph->incomplete = 0;
     crm_trace("Entering graph %d callback", graph->id);
 
-    /* Pre-calculate the number of completed and in-flight operations */
-    for (lpc = graph->synapses; lpc != NULL; lpc = lpc->next) {
-        synapse_t *synapse = (synapse_t *) lpc->data;
-
-        if (synapse->confirmed) {
-            crm_trace("Synapse %d complete", synapse->id);
-            graph->completed++;
-
-        } else if (synapse->failed == FALSE && synapse->executed) {
-            crm_trace("Synapse %d: confirmation pending", synapse->id);
-            graph->pending++;
-        }
-    }
-
-    /* Now check if there is work to do */
-    for (lpc = graph->synapses; lpc != NULL; lpc = lpc->next) {
+    /* Check only synapses whose inputs have all been confirmed, in the order
+     * they became ready. Synapses that become ready during this pass are
+     * appended to the queue and so are checked in this pass as well. The
+     * completed and pending totals are already up to date.
+     */
+    lpc = graph->ready->head;
+    while (lpc != NULL) {
         synapse_t *synapse = (synapse_t *) lpc->data;
 
         if (graph->batch_limit > 0 && graph->pending >= graph->batch_limit) {
             crm_debug("Throttling output: batch limit (%d) reached", graph->batch_limit);
             break;
-        } else if (synapse->failed) {
-            graph->skipped++;
-            continue;
 
-        } else if (synapse->confirmed || synapse->executed) {
+        } else if (synapse->failed || synapse->confirmed || synapse->executed) {
             /* Already handled */
+            failed += synapse->failed? 1 : 0;
+            lpc = remove_ready(graph, lpc);
             continue;
         }
 
@@ -295,17 +414,21 @@ run_graph(crm_graph_t * graph)
                 graph->incomplete++;
                 graph->fired--;
             }
-
-            if (synapse->confirmed == FALSE) {
-                graph->pending++;
-            }
+            retally_synapse(graph, synapse);
+            lpc = remove_ready(graph, lpc);
 
         } else {
             crm_trace("Synapse %d cannot fire", synapse->id);
             graph->incomplete++;
+            lpc = lpc->next;
         }
     }
 
+    if (graph->pending == 0 && graph->fired == 0) {
+        failed = recount_synapses(graph);
+    }
+    graph->skipped += failed;
+
     if (graph->pending == 0 && graph->fired == 0) {
         graph->complete = TRUE;
         stat_log_level = LOG_NOTICE;
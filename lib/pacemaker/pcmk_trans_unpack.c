@@ -158,6 +158,107 @@ unpack_synapse(crm_graph_t * new_graph, xmlNode * xml_synapse)
 
 static void destroy_action(crm_action_t * action);
 
+static void
+free_list(gpointer data)
+{
+    g_list_free((GList *) data);
+}
+
+/*!
+ * \internal
+ * \brief Add a synapse to the graph's dependency tracking
+ *
+ * \param[in,out] graph    Graph that synapse is part of
+ * \param[in,out] synapse  Synapse to track
+ */
+static void
+index_synapse(crm_graph_t *graph, synapse_t *synapse)
+{
+    synapse->pending_inputs = 0;
+
+    for (GList *iter = synapse->inputs; iter != NULL; iter = iter->next) {
+        crm_action_t *input = (crm_action_t *) iter->data;
+        gpointer key = GINT_TO_POINTER(input->id);
+        GList *dependents = g_hash_table_lookup(graph->dependents, key);
+
+        synapse->pending_inputs++;
+
+        // The first element is the most recently added synapse
+        if ((dependents == NULL) || (dependents->data != synapse)) {
+            g_hash_table_steal(graph->dependents, key);
+            dependents = g_list_prepend(dependents, synapse);
+            g_hash_table_insert(graph->dependents, key, dependents);
+        }
+    }
+
+    if (synapse->pending_inputs == 0) {
+        g_queue_push_tail(graph->ready, synapse);
+    }
+}
+
+/*!
+ * \internal
+ * \brief Add a graph action to the graph's lookup tables
+ *
+ * \param[in,out] graph   Graph that action is part of
+ * \param[in]     action  Action to index
+ */
+static void
+index_action(crm_graph_t *graph, crm_action_t *action)
+{
+    const char *task = NULL;
+    const char *key = NULL;
+    GList *cancels = NULL;
+
+    // If an ID is somehow duplicated, keep the first, as a scan would find
+    if (g_hash_table_lookup(graph->action_index,
+                            GINT_TO_POINTER(action->id)) == NULL) {
+        g_hash_table_insert(graph->action_index, GINT_TO_POINTER(action->id),
+                            action);
+    }
+
+    task = crm_element_value(action->xml, XML_LRM_ATTR_TASK);
+    key = crm_element_value(action->xml, XML_LRM_ATTR_TASK_KEY);
+    if (safe_str_neq(task, CRMD_ACTION_CANCEL) || (key == NULL)) {
+        return;
+    }
+
+    /* g_hash_table_steal() keeps the table from freeing the list we're about
+     * to extend (and the key, which is owned by the action XML)
+     */
+    cancels = g_hash_table_lookup(graph->cancel_index, key);
+    g_hash_table_steal(graph->cancel_index, key);
+    cancels = g_list_append(cancels, action);
+    g_hash_table_insert(graph->cancel_index, (gpointer) key, cancels);
+}
+
+/*!
+ * \internal
+ * \brief Unpack the names of node attributes a graph does not depend on
+ *
+ * \param[in,out] graph  Graph being unpacked
+ * \param[in]     xml    Graph XML listing unused node attributes
+ */
+static void
+unpack_unused_attrs(crm_graph_t *graph, xmlNode *xml)
+{
+    if (graph->unused_attrs == NULL) {
+        graph->unused_attrs = g_hash_table_new_full(crm_str_hash, g_str_equal,
+                                                    free, NULL);
+    }
+    for (xmlNode *attr = first_named_child(xml, PCMK__XE_NODE_ATTRIBUTE);
+         attr != NULL; attr = crm_next_same_xml(attr)) {
+
+        const char *name = crm_element_value(attr, XML_NVPAIR_ATTR_NAME);
+
+        if (name != NULL) {
+            char *key = strdup(name);
+
+            g_hash_table_replace(graph->unused_attrs, key, key);
+        }
+    }
+}
+
 crm_graph_t *
 unpack_graph(xmlNode * xml_graph, const char *reference)
 {
@@ -183,6 +284,13 @@ unpack_graph(xmlNode * xml_graph, const char *reference)
     new_graph->network_delay = 0;
     new_graph->stonith_timeout = 0;
     new_graph->completion_action = tg_done;
+    new_graph->action_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+    new_graph->cancel_index = g_hash_table_new_full(crm_str_hash, g_str_equal,
+                                                    NULL, free_list);
+    new_graph->dependents = g_hash_table_new_full(g_direct_hash,
+                                                  g_direct_equal, NULL,
+                                                  free_list);
+    new_graph->ready = g_queue_new();
 
     if (reference) {
         new_graph->source = strdup(reference);
@@ -192,12 +300,12 @@ unpack_graph(xmlNode * xml_graph, const char *reference)
 
     if (xml_graph != NULL) {
         t_id = crm_element_value(xml_graph, "transition_id");
-        CRM_CHECK(t_id != NULL, free(new_graph);
+        CRM_CHECK(t_id != NULL, destroy_graph(new_graph);
                   return NULL);
         new_graph->id = crm_parse_int(t_id, "-1");
 
         time = crm_element_value(xml_graph, "cluster-delay");
-        CRM_CHECK(time != NULL, free(new_graph);
+        CRM_CHECK(time != NULL, destroy_graph(new_graph);
                   return NULL);
         new_graph->network_delay = crm_parse_interval_spec(time);
 
@@ -221,10 +329,18 @@ unpack_graph(xmlNode * xml_graph, const char *reference)
 
             if (new_synapse != NULL) {
                 new_graph->synapses = g_list_append(new_graph->synapses, new_synapse);
+                for (GList *iter = new_synapse->actions; iter != NULL;
+                     iter = iter->next) {
+                    index_action(new_graph, (crm_action_t *) iter->data);
+                }
+                index_synapse(new_graph, new_synapse);
             }
+
+        } else if (crm_str_eq((const char *) synapse->name,
+                              PCMK__XE_UNUSED_NODE_ATTRS, TRUE)) {
+            unpack_unused_attrs(new_graph, synapse);
         }
     }
-
     crm_debug("Unpacked transition %d: %d actions in %d synapses",
               new_graph->id, new_graph->num_actions, new_graph->num_synapses);
 
@@ -271,6 +387,20 @@ destroy_graph(crm_graph_t * graph)
     if (graph == NULL) {
         return;
     }
+
+    // Indexes don't own the actions or synapses, so free them first
+    if (graph->ready != NULL) {
+        g_queue_free(graph->ready);
+    }
+    if (graph->dependents != NULL) {
+        g_hash_table_destroy(graph->dependents);
+    }
+    if (graph->cancel_index != NULL) {
+        g_hash_table_destroy(graph->cancel_index);
+    }
+    if (graph->action_index != NULL) {
+        g_hash_table_destroy(graph->action_index);
+    }
     while (graph->synapses != NULL) {
         synapse_t *synapse = g_list_nth_data(graph->synapses, 0);
 
@@ -278,6 +408,9 @@ destroy_graph(crm_graph_t * graph)
         destroy_synapse(synapse);
     }
 
+    if (graph->unused_attrs != NULL) {
+        g_hash_table_destroy(graph->unused_attrs);
+    }
     free(graph->source);
     free(graph);
 }
@@ -0,0 +1,230 @@
+#include <glib.h>
+
+#include <crm_internal.h>
+#include <crm/msg_xml.h>
+#include <pacemaker-internal.h>
+
+#define MAX_FIRED 10
+
+static int fired[MAX_FIRED];
+static int num_fired = 0;
+static int fail_to_fire = -1;
+
+// Record a resource action, leaving it in flight
+static gboolean
+rsc_action(crm_graph_t *graph, crm_action_t *action)
+{
+    if (action->id == fail_to_fire) {
+        return FALSE;
+    }
+    g_assert_cmpint(num_fired, <, MAX_FIRED);
+    fired[num_fired++] = action->id;
+    return TRUE;
+}
+
+// Record a pseudo-action, confirming it immediately as the controller does
+static gboolean
+pseudo_action(crm_graph_t *graph, crm_action_t *action)
+{
+    g_assert_cmpint(num_fired, <, MAX_FIRED);
+    fired[num_fired++] = action->id;
+    action->confirmed = TRUE;
+    update_graph(graph, action);
+    return TRUE;
+}
+
+static crm_graph_functions_t test_fns = {
+    pseudo_action,
+    rsc_action,
+    rsc_action,
+    rsc_action,
+    NULL
+};
+
+static crm_graph_t *
+new_graph(const char *synapses)
+{
+    char *xml_s = crm_strdup_printf("<" XML_TAG_GRAPH " transition_id=\"1\""
+                                    " cluster-delay=\"60s\">%s</"
+                                    XML_TAG_GRAPH ">", synapses);
+    xmlNode *xml = string2xml(xml_s);
+    crm_graph_t *graph = unpack_graph(xml, __FUNCTION__);
+
+    g_assert(graph != NULL);
+    free_xml(xml);
+    free(xml_s);
+
+    num_fired = 0;
+    fail_to_fire = -1;
+    set_graph_functions(&test_fns);
+    return graph;
+}
+
+// Complete an in-flight action, as the controller does when its result arrives
+static void
+complete_action(crm_graph_t *graph, int action_id, gboolean failed)
+{
+    crm_action_t *action = g_hash_table_lookup(graph->action_index,
+                                               GINT_TO_POINTER(action_id));
+
+    g_assert(action != NULL);
+    action->failed = failed;
+    action->confirmed = TRUE;
+    update_graph(graph, action);
+}
+
+static void
+assert_fired(int expected_fired, const int *expected)
+{
+    g_assert_cmpint(num_fired, ==, expected_fired);
+    for (int lpc = 0; lpc < expected_fired; lpc++) {
+        g_assert_cmpint(fired[lpc], ==, expected[lpc]);
+    }
+    num_fired = 0;
+}
+
+static void
+fire_in_order(void) {
+    /* 1 (pseudo) and 3 are ready at the start, 4 becomes ready as soon as 1 is
+     * confirmed, and 2 must wait until 3 completes
+     */
+    crm_graph_t *graph = new_graph(
+        "<synapse id=\"0\"><action_set>"
+          "<pseudo_event id=\"1\"/>"
+        "</action_set><inputs/></synapse>"
+        "<synapse id=\"1\"><action_set>"
+          "<rsc_op id=\"2\"/>"
+        "</action_set><inputs>"
+          "<trigger><rsc_op id=\"3\"/></trigger>"
+        "</inputs></synapse>"
+        "<synapse id=\"2\"><action_set>"
+          "<rsc_op id=\"3\"/>"
+        "</action_set><inputs/></synapse>"
+        "<synapse id=\"3\"><action_set>"
+          "<rsc_op id=\"4\"/>"
+        "</action_set><inputs>"
+          "<trigger><pseudo_event id=\"1\"/></trigger>"
+        "</inputs></synapse>");
+    const int first_pass[] = { 1, 3, 4 };
+    const int second_pass[] = { 2 };
+
+    g_assert_cmpint(run_graph(graph), ==, transition_active);
+    assert_fired(DIMOF(first_pass), first_pass);
+    g_assert_cmpint(graph->fired, ==, 3);
+    g_assert_cmpint(graph->completed, ==, 1);
+    g_assert_cmpint(graph->pending, ==, 2);
+
+    // Nothing has changed, so nothing more can fire
+    g_assert_cmpint(run_graph(graph), ==, transition_pending);
+    assert_fired(0, NULL);
+
+    complete_action(graph, 3, FALSE);
+    g_assert_cmpint(run_graph(graph), ==, transition_active);
+    assert_fired(DIMOF(second_pass), second_pass);
+    g_assert_cmpint(graph->completed, ==, 2);
+    g_assert_cmpint(graph->pending, ==, 2);
+
+    complete_action(graph, 2, FALSE);
+    complete_action(graph, 4, FALSE);
+    g_assert_cmpint(run_graph(graph), ==, transition_complete);
+    assert_fired(0, NULL);
+    g_assert_cmpint(graph->completed, ==, 4);
+    g_assert_cmpint(graph->pending, ==, 0);
+    g_assert_cmpint(graph->incomplete, ==, 0);
+    g_assert_cmpint(graph->skipped, ==, 0);
+    g_assert(graph->complete);
+
+    destroy_graph(graph);
+}
+
+static void
+failed_input(void) {
+    // 2 can never become ready because its input fails
+    crm_graph_t *graph = new_graph(
+        "<synapse id=\"0\"><action_set>"
+          "<rsc_op id=\"1\"/>"
+        "</action_set><inputs/></synapse>"
+        "<synapse id=\"1\"><action_set>"
+          "<rsc_op id=\"2\"/>"
+        "</action_set><inputs>"
+          "<trigger><rsc_op id=\"1\"/></trigger>"
+        "</inputs></synapse>");
+    const int expected[] = { 1 };
+
+    g_assert_cmpint(run_graph(graph), ==, transition_active);
+    assert_fired(DIMOF(expected), expected);
+
+    complete_action(graph, 1, TRUE);
+    g_assert_cmpint(run_graph(graph), ==, transition_terminated);
+    assert_fired(0, NULL);
+    g_assert_cmpint(graph->completed, ==, 1);
+    g_assert_cmpint(graph->pending, ==, 0);
+    g_assert_cmpint(graph->incomplete, ==, 1);
+
+    destroy_graph(graph);
+}
+
+static void
+failed_synapse(void) {
+    // The synapse fails while in flight, such as when its node is lost
+    crm_graph_t *graph = new_graph(
+        "<synapse id=\"0\"><action_set>"
+          "<rsc_op id=\"1\"/>"
+        "</action_set><inputs/></synapse>");
+    const int expected[] = { 1 };
+    synapse_t *synapse = NULL;
+
+    g_assert_cmpint(run_graph(graph), ==, transition_active);
+    assert_fired(DIMOF(expected), expected);
+    g_assert_cmpint(graph->pending, ==, 1);
+
+    synapse = (synapse_t *) graph->synapses->data;
+    synapse->failed = TRUE;
+    complete_action(graph, 1, TRUE);
+    g_assert_cmpint(graph->pending, ==, 0);
+
+    g_assert_cmpint(run_graph(graph), ==, transition_complete);
+    g_assert_cmpint(graph->completed, ==, 0);
+    g_assert_cmpint(graph->incomplete, ==, 0);
+    g_assert_cmpint(graph->skipped, ==, 1);
+
+    destroy_graph(graph);
+}
+
+static void
+fire_failure(void) {
+    // 1 can't be initiated, which aborts the transition before 2 can fire
+    crm_graph_t *graph = new_graph(
+        "<synapse id=\"0\"><action_set>"
+          "<rsc_op id=\"1\"/>"
+        "</action_set><inputs/></synapse>"
+        "<synapse id=\"1\"><action_set>"
+          "<rsc_op id=\"2\"/>"
+        "</action_set><inputs/></synapse>");
+
+    fail_to_fire = 1;
+    g_assert_cmpint(run_graph(graph), ==, transition_complete);
+    assert_fired(0, NULL);
+    g_assert_cmpint(graph->abort_priority, ==, INFINITY);
+    g_assert_cmpint(graph->fired, ==, 0);
+    g_assert_cmpint(graph->completed, ==, 1);
+    g_assert_cmpint(graph->pending, ==, 0);
+    g_assert_cmpint(graph->incomplete, ==, 1);
+    g_assert_cmpint(graph->skipped, ==, 1);
+
+    destroy_graph(graph);
+}
+
+int main(int argc, char **argv) {
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/pacemaker/transition/run_graph/order", fire_in_order);
+    g_test_add_func("/pacemaker/transition/run_graph/failed_input",
+                    failed_input);
+    g_test_add_func("/pacemaker/transition/run_graph/failed_synapse",
+                    failed_synapse);
+    g_test_add_func("/pacemaker/transition/run_graph/fire_failure",
+                    fire_failure);
+
+    return g_test_run();
+}
@@ -497,6 +497,7 @@ services_action_free(svc_action_t * op)
     for (i = 0; i < DIMOF(op->opaque->args); i++) {
         free(op->opaque->args[i]);
     }
+    g_strfreev(op->opaque->envp);
 
     free(op->opaque);
     free(op->rsc);
@@ -24,12 +24,18 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 
+#if HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+#  include <spawn.h>
+#endif
+
 #include "crm/crm.h"
 #include "crm/common/mainloop.h"
 #include "crm/services.h"
 
 #include "services_private.h"
 
+extern char **environ;
+
 static void close_pipe(int fildes[]);
 
 /* We have two alternative ways of handling SIGCHLD when synchronously waiting
@@ -359,12 +365,16 @@ static struct mainloop_fd_callbacks stderr_callbacks = {
     .destroy = pipe_err_done,
 };
 
+/* The environment setters below take a (gchar ***) environment to update as
+ * user data
+ */
+
 static void
 set_ocf_env(const char *key, const char *value, gpointer user_data)
 {
-    if (setenv(key, value, 1) != 0) {
-        crm_perror(LOG_ERR, "setenv failed for key:%s and value:%s", key, value);
-    }
+    gchar ***envp = user_data;
+
+    *envp = g_environ_setenv(*envp, key, value, TRUE);
 }
 
 static void
@@ -379,30 +389,26 @@ set_ocf_env_with_prefix(gpointer key, gpointer value, gpointer user_data)
 static void
 set_alert_env(gpointer key, gpointer value, gpointer user_data)
 {
-    int rc;
+    gchar ***envp = user_data;
 
     if (value != NULL) {
-        rc = setenv(key, value, 1);
+        *envp = g_environ_setenv(*envp, key, value, TRUE);
     } else {
-        rc = unsetenv(key);
-    }
-
-    if (rc < 0) {
-        crm_perror(LOG_ERR, "setenv %s=%s",
-                  (char*)key, (value? (char*)value : ""));
-    } else {
-        crm_trace("setenv %s=%s", (char*)key, (value? (char*)value : ""));
+        *envp = g_environ_unsetenv(*envp, key);
     }
+    crm_trace("setenv %s=%s", (char*)key, (value? (char*)value : ""));
 }
 
 /*!
  * \internal
  * \brief Add environment variables suitable for an action
  *
- * \param[in] op  Action to use
+ * \param[in]     op      Action to use
+ * \param[in]     params  Parameters to use (normally op->params)
+ * \param[in,out] envp    Environment to add to
  */
 static void
-add_action_env_vars(const svc_action_t *op)
+add_action_env_vars(const svc_action_t *op, GHashTable *params, gchar ***envp)
 {
     void (*env_setter)(gpointer, gpointer, gpointer) = NULL;
     if (op->agent == NULL) {
@@ -412,31 +418,102 @@ add_action_env_vars(const svc_action_t *op)
         env_setter = set_ocf_env_with_prefix;
     }
 
-    if (env_setter != NULL && op->params != NULL) {
-        g_hash_table_foreach(op->params, env_setter, NULL);
+    if (env_setter != NULL && params != NULL) {
+        g_hash_table_foreach(params, env_setter, envp);
     }
 
     if (env_setter == NULL || env_setter == set_alert_env) {
         return;
     }
 
-    set_ocf_env("OCF_RA_VERSION_MAJOR", "1", NULL);
-    set_ocf_env("OCF_RA_VERSION_MINOR", "0", NULL);
-    set_ocf_env("OCF_ROOT", OCF_ROOT_DIR, NULL);
-    set_ocf_env("OCF_EXIT_REASON_PREFIX", PCMK_OCF_REASON_PREFIX, NULL);
+    set_ocf_env("OCF_RA_VERSION_MAJOR", "1", envp);
+    set_ocf_env("OCF_RA_VERSION_MINOR", "0", envp);
+    set_ocf_env("OCF_ROOT", OCF_ROOT_DIR, envp);
+    set_ocf_env("OCF_EXIT_REASON_PREFIX", PCMK_OCF_REASON_PREFIX, envp);
 
     if (op->rsc) {
-        set_ocf_env("OCF_RESOURCE_INSTANCE", op->rsc, NULL);
+        set_ocf_env("OCF_RESOURCE_INSTANCE", op->rsc, envp);
     }
 
     if (op->agent != NULL) {
-        set_ocf_env("OCF_RESOURCE_TYPE", op->agent, NULL);
+        set_ocf_env("OCF_RESOURCE_TYPE", op->agent, envp);
     }
 
     /* Notes: this is not added to specification yet. Sept 10,2004 */
     if (op->provider != NULL) {
-        set_ocf_env("OCF_RESOURCE_PROVIDER", op->provider, NULL);
+        set_ocf_env("OCF_RESOURCE_PROVIDER", op->provider, envp);
+    }
+}
+
+#if SUPPORT_CIBSECRETS
+static gboolean
+is_secret_param(gpointer key, gpointer value, gpointer user_data)
+{
+    return (value != NULL) && pcmk__starts_with((const char *) value, "lrm://");
+}
+#endif
+
+/*!
+ * \internal
+ * \brief Get the environment to run an action's child with
+ *
+ * The environment is built here rather than in the child, so that the child
+ * can exec immediately. The parameters of a recurring action can't change, so
+ * its environment is kept for later runs (unless it includes CIB secrets,
+ * which must be re-read in case they changed, and which we don't want to keep
+ * in memory longer than needed).
+ *
+ * \param[in,out] op    Action to get environment for
+ * \param[out]    envp  Where to store environment
+ *
+ * \return Standard Pacemaker return code
+ * \note Unless \p *envp is op->opaque->envp, the caller is responsible for
+ *       freeing it with g_strfreev().
+ */
+static int
+action_environment(svc_action_t *op, gchar ***envp)
+{
+    GHashTable *params = op->params;
+    bool cacheable = (op->interval_ms > 0);
+
+    if (op->opaque->envp != NULL) {
+        *envp = op->opaque->envp;
+        return pcmk_rc_ok;
+    }
+
+#if SUPPORT_CIBSECRETS
+    if (params && g_hash_table_find(params, is_secret_param, NULL)) {
+        // Substitute into a copy, so secrets aren't kept with the action
+        int rc;
+
+        params = crm_str_table_dup(op->params);
+        rc = pcmk__substitute_secrets(op->rsc, params);
+        if (rc != pcmk_rc_ok) {
+            if (safe_str_eq(op->action, "stop")) {
+                /* don't fail on stop! */
+                crm_info("proceeding with the stop operation for %s", op->rsc);
+
+            } else {
+                crm_err("failed to get secrets for %s, "
+                        "considering resource not configured", op->rsc);
+                g_hash_table_destroy(params);
+                return rc;
+            }
+        }
+        cacheable = FALSE;
+    }
+#endif
+
+    *envp = g_get_environ();
+    add_action_env_vars(op, params, envp);
+    if (params != op->params) {
+        g_hash_table_destroy(params);
     }
+
+    if (cacheable) {
+        op->opaque->envp = *envp;
+    }
+    return pcmk_rc_ok;
 }
 
 static void
@@ -490,6 +567,85 @@ recurring_action_timer(gpointer data)
     return FALSE;
 }
 
+/*!
+ * \internal
+ * \brief Get the configured spreading of recurring actions
+ *
+ * \param[out] coalesce  Whether to coalesce recurring action wakeups
+ *
+ * \return Percentage of interval over which to spread recurring actions
+ */
+static int
+recurring_spread(bool *coalesce)
+{
+    static bool checked = FALSE;
+    static bool coalesce_s = FALSE;
+    static int spread = 0;
+
+    if (!checked) {
+        const char *value = pcmk__env_option("recurring_spread");
+
+        if (value != NULL) {
+            spread = crm_parse_int(value, "0");
+            if ((spread < 0) || (spread > 100)) {
+                crm_warn("Ignoring invalid recurring action spread '%s'",
+                         value);
+                spread = 0;
+            }
+        }
+        coalesce_s = pcmk__env_option_enabled(crm_system_name,
+                                              "recurring_coalesce");
+        checked = TRUE;
+    }
+    *coalesce = coalesce_s;
+    return spread;
+}
+
+/*!
+ * \internal
+ * \brief Start the timer for the next run of a recurring action
+ *
+ * Actions started together (for example, after a node boots) would otherwise
+ * keep running in lockstep. If spreading is configured, the first repeat of
+ * each action is brought forward by an amount derived from its ID, so actions
+ * with the same interval are scattered across (a portion of) the interval and
+ * stay that way. Because the offset is deterministic, an action that is
+ * re-created keeps the same phase.
+ *
+ * \param[in,out] op  Recurring action to schedule
+ */
+static void
+schedule_recurring_action(svc_action_t *op)
+{
+    bool coalesce = FALSE;
+    int spread = recurring_spread(&coalesce);
+    guint delay_ms = op->interval_ms;
+
+    if ((spread > 0) && !op->opaque->repeat_spread) {
+        guint window_ms = (guint) (((guint64) op->interval_ms * spread) / 100);
+
+        if (window_ms > 0) {
+            delay_ms -= g_str_hash(op->id) % window_ms;
+            crm_trace("Offsetting first repeat of %s by -%ums",
+                      op->id, op->interval_ms - delay_ms);
+        }
+        op->opaque->repeat_spread = TRUE;
+    }
+
+    /* glib fires all second-granularity timers of a process together, which
+     * reduces wakeups at the cost of up to a second of precision
+     */
+    if (coalesce && (delay_ms >= 1000)) {
+        op->opaque->repeat_timer = g_timeout_add_seconds((delay_ms + 500) / 1000,
+                                                         recurring_action_timer,
+                                                         (void *) op);
+    } else {
+        op->opaque->repeat_timer = g_timeout_add(delay_ms,
+                                                 recurring_action_timer,
+                                                 (void *) op);
+    }
+}
+
 /* Returns FALSE if 'op' should be free'd by the caller */
 gboolean
 operation_finalize(svc_action_t * op)
@@ -502,8 +658,7 @@ operation_finalize(svc_action_t * op)
             cancel_recurring_action(op);
         } else {
             recurring = 1;
-            op->opaque->repeat_timer = g_timeout_add(op->interval_ms,
-                                                     recurring_action_timer, (void *)op);
+            schedule_recurring_action(op);
         }
     }
 
@@ -624,7 +779,8 @@ operation_finished(mainloop_child_t * p, pid_t pid, int core, int signo, int exi
 
 /*!
  * \internal
- * \brief Set operation rc and status per errno from stat(), fork() or execvp()
+ * \brief Set operation rc and status per errno from stat(), fork(),
+ *        posix_spawnp() or execvp()
  *
  * \param[in,out] op     Operation to set rc and status for
  * \param[in]     error  Value of errno after system call
@@ -678,7 +834,7 @@ services_handle_exec_error(svc_action_t * op, int error)
 }
 
 static void
-action_launch_child(svc_action_t *op)
+action_launch_child(svc_action_t *op, gchar **envp)
 {
     /* SIGPIPE is ignored (which is different from signal blocking) by the gnutls library.
      * Depending on the libqb version in use, libqb may set SIGPIPE to be ignored as well. 
@@ -711,22 +867,8 @@ action_launch_child(svc_action_t *op)
 
     pcmk__close_fds_in_child(false);
 
-#if SUPPORT_CIBSECRETS
-    if (pcmk__substitute_secrets(op->rsc, op->params) != pcmk_rc_ok) {
-        /* replacing secrets failed! */
-        if (safe_str_eq(op->action,"stop")) {
-            /* don't fail on stop! */
-            crm_info("proceeding with the stop operation for %s", op->rsc);
-
-        } else {
-            crm_err("failed to get secrets for %s, "
-                    "considering resource not configured", op->rsc);
-            _exit(PCMK_OCF_NOT_CONFIGURED);
-        }
-    }
-#endif
-
-    add_action_env_vars(op);
+    // Environment was prepared by parent (execvp() still searches our PATH)
+    environ = envp;
 
     /* Become the desired user */
     if (op->opaque->uid && (geteuid() == 0)) {
@@ -760,6 +902,110 @@ action_launch_child(svc_action_t *op)
     _exit(op->rc);
 }
 
+#if HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+
+/*!
+ * \internal
+ * \brief Check whether an action's child can be created with posix_spawn()
+ *
+ * posix_spawn() lets the child share our address space until it execs (like
+ * vfork()), which avoids copying the page tables of a large daemon for every
+ * agent run. However, it can only do a subset of the setup that
+ * action_launch_child() does, so anything needing more uses fork().
+ *
+ * \param[in] op  Action to check
+ *
+ * \return TRUE if \p op can be spawned, otherwise FALSE
+ */
+static gboolean
+action_can_spawn(const svc_action_t *op)
+{
+    /* Synchronous actions need SIGCHLD handling undone in the child, and are
+     * too rare to matter
+     */
+    if (op->synchronous) {
+        return FALSE;
+    }
+
+    // The child can't switch users or reset its priority
+    if (op->opaque->uid && (geteuid() == 0)) {
+        return FALSE;
+    }
+    errno = 0;
+    if ((getpriority(PRIO_PROCESS, 0) != 0) || (errno != 0)) {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*!
+ * \internal
+ * \brief Create an action's child process with posix_spawn()
+ *
+ * \param[in,out] op         Action to execute (pid will be set on success)
+ * \param[in]     envp       Environment for child
+ * \param[in]     stdin_fd   Pipe for child's input (or -1s for none)
+ * \param[in]     stdout_fd  Pipe for child's output
+ * \param[in]     stderr_fd  Pipe for child's error output
+ *
+ * \return Standard errno code (0 on success)
+ */
+static int
+action_spawn_child(svc_action_t *op, gchar **envp, int stdin_fd[],
+                   int stdout_fd[], int stderr_fd[])
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t sigdefault;
+    short flags = POSIX_SPAWN_SETPGROUP|POSIX_SPAWN_SETSIGDEF;
+    pid_t pid = 0;
+    int rc = 0;
+
+    posix_spawn_file_actions_init(&actions);
+    if (stdin_fd[0] >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, stdin_fd[0], STDIN_FILENO);
+    }
+    posix_spawn_file_actions_adddup2(&actions, stdout_fd[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, stderr_fd[1], STDERR_FILENO);
+    posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+
+    posix_spawnattr_init(&attr);
+
+    // New process group, as with setpgid(0, 0) in action_launch_child()
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    // See action_launch_child() for why SIGPIPE is reset
+    sigemptyset(&sigdefault);
+    sigaddset(&sigdefault, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &sigdefault);
+
+#if defined(HAVE_SCHED_SETSCHEDULER)
+    if (sched_getscheduler(0) != SCHED_OTHER) {
+        struct sched_param sp;
+
+        memset(&sp, 0, sizeof(sp));
+        sp.sched_priority = 0;
+        posix_spawnattr_setschedpolicy(&attr, SCHED_OTHER);
+        posix_spawnattr_setschedparam(&attr, &sp);
+        flags |= POSIX_SPAWN_SETSCHEDULER;
+    }
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+
+    rc = posix_spawnp(&pid, op->opaque->exec, &actions, &attr,
+                      op->opaque->args, envp);
+    if (rc == 0) {
+        op->pid = pid;
+        crm_trace("Spawned '%s'[%d]", op->opaque->exec, pid);
+    }
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return rc;
+}
+
+#endif // HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+
 static void
 action_synced_wait(svc_action_t *op, struct sigchld_data_s *data)
 {
@@ -885,6 +1131,8 @@ services_os_action_execute(svc_action_t * op)
     int rc;
     struct stat st;
     struct sigchld_data_s data;
+    gchar **envp = NULL;
+    const char *stage = "fork";  // What failed, if creating the child fails
 
     /* Fail fast */
     if(stat(op->opaque->exec, &st) != 0) {
@@ -948,7 +1196,44 @@ services_os_action_execute(svc_action_t * op)
         return FALSE;
     }
 
+    rc = action_environment(op, &envp);
+    if (rc != pcmk_rc_ok) {
+        close_pipe(stdin_fd);
+        close_pipe(stdout_fd);
+        close_pipe(stderr_fd);
+        if (op->synchronous) {
+            sigchld_cleanup(&data);
+        }
+
+        // Same result the child used to exit with in this case
+        op->rc = PCMK_OCF_NOT_CONFIGURED;
+        op->status = PCMK_LRM_OP_DONE;
+        if (!op->synchronous) {
+            return operation_finalize(op);
+        }
+        return TRUE;
+    }
+
+#if HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+    if (action_can_spawn(op)) {
+        /* posix_spawnp() reports failures from the child's setup and exec as
+         * well as from creating the child
+         */
+        stage = "posix_spawnp";
+        rc = action_spawn_child(op, envp, stdin_fd, stdout_fd, stderr_fd);
+        if (rc != 0) {
+            op->pid = -1;
+            errno = rc;
+        }
+    } else {
+        op->pid = fork();
+    }
+#else
     op->pid = fork();
+#endif
+    if ((op->pid != 0) && (envp != op->opaque->envp)) {
+        g_strfreev(envp);   // Child (if any) has its own copy
+    }
     switch (op->pid) {
         case -1:
             rc = errno;
@@ -956,8 +1241,8 @@ services_os_action_execute(svc_action_t * op)
             close_pipe(stdout_fd);
             close_pipe(stderr_fd);
 
-            crm_err("Cannot execute '%s': %s " CRM_XS " fork rc=%d",
-                    op->opaque->exec, pcmk_strerror(rc), rc);
+            crm_err("Cannot execute '%s': %s " CRM_XS " %s rc=%d",
+                    op->opaque->exec, pcmk_strerror(rc), stage, rc);
             services_handle_exec_error(op, rc);
             if (!op->synchronous) {
                 return operation_finalize(op);
@@ -1002,7 +1287,7 @@ services_os_action_execute(svc_action_t * op)
                 sigchld_cleanup(&data);
             }
 
-            action_launch_child(op);
+            action_launch_child(op, envp);
             CRM_ASSERT(0);  /* action_launch_child is effectively noreturn */
     }
 
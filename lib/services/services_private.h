@@ -19,11 +19,13 @@
 struct svc_action_private_s {
     char *exec;
     char *args[MAX_ARGC];
+    gchar **envp;       // Cached child environment (recurring actions only)
 
     uid_t uid;
     gid_t gid;
 
     guint repeat_timer;
+    gboolean repeat_spread;     // Whether first repeat has been offset
     void (*callback) (svc_action_t * op);
     void (*fork_callback) (svc_action_t * op);
 
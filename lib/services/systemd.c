@@ -20,12 +20,21 @@
 #include <pcmk-dbus.h>
 
 gboolean systemd_unit_exec_with_unit(svc_action_t * op, const char *unit);
+static void systemd_forget_units(void);
 
 #define BUS_NAME         "org.freedesktop.systemd1"
 #define BUS_NAME_MANAGER BUS_NAME ".Manager"
 #define BUS_NAME_UNIT    BUS_NAME ".Unit"
 #define BUS_PATH         "/org/freedesktop/systemd1"
 
+#define BUS_PROPERTY_IFACE "org.freedesktop.DBus.Properties"
+
+/* How long (in seconds) a unit state learned from systemd may be used for
+ * monitors without asking systemd again. Changes are normally pushed to us as
+ * they happen, so this only limits the damage if a signal is ever lost.
+ */
+#define SYSTEMD_STATE_MAX_AGE 600
+
 static inline DBusMessage *
 systemd_new_method(const char *method)
 {
@@ -109,6 +118,7 @@ systemd_init(void)
         crm_warn("Connection to System DBus is closed. Reconnecting...");
         pcmk_dbus_disconnect(systemd_proxy);
         systemd_proxy = NULL;
+        systemd_forget_units();
         need_init = 1;
     }
 
@@ -140,6 +150,7 @@ systemd_cleanup(void)
         pcmk_dbus_disconnect(systemd_proxy);
         systemd_proxy = NULL;
     }
+    systemd_forget_units();
 }
 
 /*
@@ -185,6 +196,280 @@ systemd_service_name(const char *name)
     return crm_strdup_printf("%s.service", name);
 }
 
+/*
+ * Cache of unit states, kept current by systemd's PropertiesChanged signals,
+ * so that monitors of managed units don't need any DBus calls
+ */
+
+struct systemd_unit_s {
+    char *name;             // Agent name as used in resource definition
+    char *path;             // DBus object path of unit
+    char *active_state;     // Last known ActiveState (or NULL if unknown)
+    time_t updated;         // When active_state was last set
+};
+
+static GHashTable *units_by_name = NULL;   // Agent name -> systemd_unit_s
+static GHashTable *units_by_path = NULL;   // Object path -> same systemd_unit_s
+static bool subscribed = FALSE;            // Whether systemd is sending signals
+static bool matched = FALSE;               // Whether bus is routing signals to us
+static bool filter_added = FALSE;          // Whether our signal filter is set
+
+static void
+free_systemd_unit(gpointer data)
+{
+    struct systemd_unit_s *unit = data;
+
+    free(unit->name);
+    free(unit->path);
+    free(unit->active_state);
+    free(unit);
+}
+
+static void
+systemd_forget_units(void)
+{
+    if (units_by_path != NULL) {
+        g_hash_table_destroy(units_by_path);
+        units_by_path = NULL;
+    }
+    if (units_by_name != NULL) {
+        g_hash_table_destroy(units_by_name);
+        units_by_name = NULL;
+    }
+    subscribed = FALSE;
+    matched = FALSE;
+    filter_added = FALSE;
+}
+
+static void
+set_unit_state(struct systemd_unit_s *unit, const char *state)
+{
+    if (safe_str_neq(unit->active_state, state)) {
+        crm_trace("Unit %s is now %s", unit->name, (state? state : "unknown"));
+        free(unit->active_state);
+        unit->active_state = state? strdup(state) : NULL;
+    }
+    unit->updated = time(NULL);
+}
+
+static void
+unit_properties_changed(struct systemd_unit_s *unit, DBusMessage *msg)
+{
+    DBusMessageIter args;
+    DBusMessageIter dict;
+    const char *iface = NULL;
+
+    // Signature is (s interface, a{sv} changed, as invalidated)
+    if (!dbus_message_iter_init(msg, &args)
+        || (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_STRING)) {
+        return;
+    }
+    dbus_message_iter_get_basic(&args, &iface);
+    if (safe_str_neq(iface, BUS_NAME_UNIT) || !dbus_message_iter_next(&args)
+        || (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_ARRAY)) {
+        return;
+    }
+
+    dbus_message_iter_recurse(&args, &dict);
+    for (; dbus_message_iter_get_arg_type(&dict) == DBUS_TYPE_DICT_ENTRY;
+         dbus_message_iter_next(&dict)) {
+
+        DBusMessageIter entry;
+        DBusMessageIter variant;
+        const char *name = NULL;
+        const char *value = NULL;
+
+        dbus_message_iter_recurse(&dict, &entry);
+        dbus_message_iter_get_basic(&entry, &name);
+        if (safe_str_neq(name, "ActiveState")
+            || !dbus_message_iter_next(&entry)
+            || (dbus_message_iter_get_arg_type(&entry) != DBUS_TYPE_VARIANT)) {
+            continue;
+        }
+        dbus_message_iter_recurse(&entry, &variant);
+        if (dbus_message_iter_get_arg_type(&variant) == DBUS_TYPE_STRING) {
+            dbus_message_iter_get_basic(&variant, &value);
+            set_unit_state(unit, value);
+            return;
+        }
+    }
+
+    // If the value was merely invalidated, we'll have to ask next time
+    if (dbus_message_iter_next(&args)
+        && (dbus_message_iter_get_arg_type(&args) == DBUS_TYPE_ARRAY)) {
+
+        DBusMessageIter names;
+
+        dbus_message_iter_recurse(&args, &names);
+        for (; dbus_message_iter_get_arg_type(&names) == DBUS_TYPE_STRING;
+             dbus_message_iter_next(&names)) {
+
+            const char *name = NULL;
+
+            dbus_message_iter_get_basic(&names, &name);
+            if (safe_str_eq(name, "ActiveState")) {
+                free(unit->active_state);
+                unit->active_state = NULL;
+                return;
+            }
+        }
+    }
+}
+
+/* The bus delivers PropertiesChanged signals for every systemd unit, so only
+ * those for units we are watching (by object path) are used
+ */
+static DBusHandlerResult
+systemd_signal_filter(DBusConnection *connection, DBusMessage *msg,
+                      void *user_data)
+{
+    if ((units_by_path != NULL)
+        && dbus_message_is_signal(msg, BUS_PROPERTY_IFACE,
+                                  "PropertiesChanged")) {
+
+        struct systemd_unit_s *unit = NULL;
+        const char *path = dbus_message_get_path(msg);
+
+        if (path != NULL) {
+            unit = g_hash_table_lookup(units_by_path, path);
+        }
+        if (unit != NULL) {
+            unit_properties_changed(unit, msg);
+        }
+    }
+
+    // Let anything else interested see the message, too
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static void
+systemd_subscribe_complete(DBusPendingCall *pending, void *user_data)
+{
+    DBusError error;
+    DBusMessage *reply = NULL;
+
+    dbus_error_init(&error);
+    if (pending) {
+        reply = dbus_pending_call_steal_reply(pending);
+    }
+
+    if (pcmk_dbus_find_error(pending, reply, &error)) {
+        crm_warn("Could not subscribe to systemd unit changes "
+                 "(monitors will query systemd each time): %s", error.message);
+        dbus_error_free(&error);
+
+    } else {
+        crm_debug("Subscribed to systemd unit changes");
+        subscribed = TRUE;
+    }
+
+    if (pending) {
+        dbus_pending_call_unref(pending);
+    }
+    if (reply) {
+        dbus_message_unref(reply);
+    }
+}
+
+/*!
+ * \internal
+ * \brief Remember a unit's object path, and watch it for state changes
+ *
+ * \param[in] name  Agent name of unit
+ * \param[in] path  DBus object path of unit
+ */
+static void
+systemd_watch_unit(const char *name, const char *path)
+{
+    struct systemd_unit_s *unit = NULL;
+
+    if (units_by_name == NULL) {
+        units_by_name = g_hash_table_new_full(crm_str_hash, g_str_equal, NULL,
+                                              free_systemd_unit);
+        units_by_path = g_hash_table_new(crm_str_hash, g_str_equal);
+    }
+
+    unit = g_hash_table_lookup(units_by_name, name);
+    if ((unit != NULL) && safe_str_eq(unit->path, path)) {
+        return;
+    }
+
+    if (!filter_added) {
+        DBusMessage *msg = systemd_new_method("Subscribe");
+        DBusError error;
+
+        /* systemd doesn't send unit signals at all unless a client has
+         * subscribed, and we don't trust the cache until it has confirmed
+         */
+        CRM_ASSERT(msg != NULL);
+        systemd_send(msg, systemd_subscribe_complete, NULL,
+                     DBUS_TIMEOUT_USE_DEFAULT);
+        dbus_message_unref(msg);
+        dbus_connection_add_filter(systemd_proxy, systemd_signal_filter, NULL,
+                                   NULL);
+        filter_added = TRUE;
+
+        /* A single match rule covers all units, so the bus is asked (and
+         * waited for) only once per connection, and the cache isn't trusted
+         * unless the bus accepted the rule
+         */
+        dbus_error_init(&error);
+        dbus_bus_add_match(systemd_proxy,
+                           "type='signal',sender='" BUS_NAME "',"
+                           "interface='" BUS_PROPERTY_IFACE "',"
+                           "member='PropertiesChanged',"
+                           "arg0='" BUS_NAME_UNIT "'", &error);
+        if (dbus_error_is_set(&error)) {
+            crm_warn("Could not watch systemd unit changes "
+                     "(monitors will query systemd each time): %s",
+                     error.message);
+            dbus_error_free(&error);
+
+        } else {
+            matched = TRUE;
+        }
+    }
+
+    if (unit != NULL) { // Path changed (not expected), so start over
+        g_hash_table_remove(units_by_path, unit->path);
+        g_hash_table_remove(units_by_name, name);
+    }
+    unit = calloc(1, sizeof(struct systemd_unit_s));
+    CRM_ASSERT(unit != NULL);
+    unit->name = strdup(name);
+    unit->path = strdup(path);
+    g_hash_table_insert(units_by_name, unit->name, unit);
+    g_hash_table_insert(units_by_path, unit->path, unit);
+    crm_trace("Watching systemd unit %s at %s", name, path);
+}
+
+static struct systemd_unit_s *
+systemd_find_unit(const char *name)
+{
+    return units_by_name? g_hash_table_lookup(units_by_name, name) : NULL;
+}
+
+/*!
+ * \internal
+ * \brief Get a unit's cached state, if it can be trusted
+ *
+ * \param[in] name  Agent name of unit
+ *
+ * \return Unit's ActiveState if known and current, otherwise NULL
+ */
+static const char *
+systemd_cached_state(const char *name)
+{
+    struct systemd_unit_s *unit = systemd_find_unit(name);
+
+    if (!subscribed || !matched || (unit == NULL)
+        || (unit->active_state == NULL)
+        || ((time(NULL) - unit->updated) > SYSTEMD_STATE_MAX_AGE)) {
+        return NULL;
+    }
+    return unit->active_state;
+}
+
 static void
 systemd_daemon_reload_complete(DBusPendingCall *pending, void *user_data)
 {
@@ -273,6 +558,7 @@ systemd_loadunit_result(DBusMessage *reply, svc_action_t * op)
 
     if(op) {
         if (path) {
+            systemd_watch_unit(op->agent, path);
             systemd_unit_exec_with_unit(op, path);
 
         } else if (op->synchronous == FALSE) {
@@ -686,13 +972,10 @@ systemd_remove_override(const char *agent, int timeout)
     free(override_file);
 }
 
+// Map a unit's ActiveState to a monitor result, and finalize the action
 static void
-systemd_unit_check(const char *name, const char *state, void *userdata)
+systemd_unit_result(svc_action_t *op, const char *state)
 {
-    svc_action_t * op = userdata;
-
-    crm_trace("Resource %s has %s='%s'", op->rsc, name, state);
-
     if(state == NULL) {
         op->rc = PCMK_OCF_NOT_RUNNING;
 
@@ -714,6 +997,19 @@ systemd_unit_check(const char *name, const char *state, void *userdata)
     }
 }
 
+static void
+systemd_unit_check(const char *name, const char *state, void *userdata)
+{
+    svc_action_t * op = userdata;
+    struct systemd_unit_s *unit = systemd_find_unit(op->agent);
+
+    crm_trace("Resource %s has %s='%s'", op->rsc, name, state);
+    if (unit != NULL) {
+        set_unit_state(unit, state);
+    }
+    systemd_unit_result(op, state);
+}
+
 gboolean
 systemd_unit_exec_with_unit(svc_action_t * op, const char *unit)
 {
@@ -723,6 +1019,18 @@ systemd_unit_exec_with_unit(svc_action_t * op, const char *unit)
 
     CRM_ASSERT(unit);
 
+    if (safe_str_neq(op->action, "monitor") && safe_str_neq(method, "status")) {
+        /* The unit's state is about to change, and we might not hear about it
+         * before the next monitor
+         */
+        struct systemd_unit_s *cached = systemd_find_unit(op->agent);
+
+        if (cached != NULL) {
+            free(cached->active_state);
+            cached->active_state = NULL;
+        }
+    }
+
     if (safe_str_eq(op->action, "monitor") || safe_str_eq(method, "status")) {
         DBusPendingCall *pending = NULL;
         char *state;
@@ -843,6 +1151,20 @@ systemd_unit_exec(svc_action_t * op)
         return TRUE;
     }
 
+    if (safe_str_eq(op->action, "monitor")
+        || safe_str_eq(op->action, "status")) {
+        const char *state = systemd_cached_state(op->agent);
+
+        if (state != NULL) {
+            crm_trace("Using cached state of systemd unit %s", op->agent);
+            systemd_unit_result(op, state);
+            if (op->synchronous == FALSE) {
+                return TRUE; // systemd_unit_result() finalized op
+            }
+            return op->rc == PCMK_OCF_OK;
+        }
+    }
+
     unit = systemd_unit_by_name(op->agent, op);
     free(unit);
 
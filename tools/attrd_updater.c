@@ -69,6 +69,17 @@ static pcmk__cli_option_t long_options[] = {
             "effectiveness.",
         pcmk__option_default
     },
+    {
+        "update-many", no_argument, NULL, 'M',
+        "Update many attributes in a single request to pacemaker-attrd, "
+            "which applies them all together. Updates are read from standard "
+            "input, one per line, as NAME=VALUE (an empty value deletes the "
+            "attribute), optionally followed by node=NODE and/or delay=DELAY. "
+            "Words are split and quoted as in a shell, so a value containing "
+            "whitespace can be given as NAME=\"VALUE\". -N/--node and "
+            "-d/--delay give the defaults. -n/--name is not used.",
+        pcmk__option_default
+    },
     {
         "query", no_argument, NULL, 'Q',
         "\tQuery the attribute's value from pacemaker-attrd",
@@ -146,6 +157,9 @@ static int do_query(const char *attr_name, const char *attr_node, gboolean query
 static int do_update(char command, const char *attr_node, const char *attr_name,
                      const char *attr_value, const char *attr_section,
                      const char *attr_set, const char *attr_dampen, int attr_options);
+static int do_update_many(const char *attr_node, const char *attr_section,
+                          const char *attr_set, const char *attr_dampen,
+                          int attr_options);
 
 // Free memory at exit to make analyzers happy
 #define cleanup_memory() \
@@ -226,6 +240,7 @@ main(int argc, char **argv)
                 break;
             case 'q':
                 break;
+            case 'M':
             case 'Y':
                 command = flag;
                 crm_log_args(argc, argv); /* Too much? */
@@ -250,7 +265,7 @@ main(int argc, char **argv)
         ++argerr;
     }
 
-    if (command != 'R' && attr_name == NULL) {
+    if ((command != 'R') && (command != 'M') && (attr_name == NULL)) {
         ++argerr;
     }
 
@@ -261,6 +276,10 @@ main(int argc, char **argv)
 
     if (command == 'Q') {
         exit_code = crm_errno2exit(do_query(attr_name, attr_node, query_all));
+    } else if (command == 'M') {
+        exit_code = pcmk_rc2exitc(do_update_many(attr_node, attr_section,
+                                                 attr_set, attr_dampen,
+                                                 attr_options));
     } else {
         /* @TODO We don't know whether the specified node is a Pacemaker Remote
          * node or not, so we can't set pcmk__node_attr_remote when appropriate.
@@ -464,3 +483,116 @@ do_update(char command, const char *attr_node, const char *attr_name,
     }
     return rc;
 }
+
+/*!
+ * \internal
+ * \brief Parse one line of --update-many input
+ *
+ * \param[in] words   Line split into words (will be referenced by result)
+ * \param[in] node    Default node for update
+ * \param[in] dampen  Default dampening for update
+ *
+ * \return Newly allocated update on success, otherwise NULL
+ */
+static pcmk__node_attr_update_t *
+parse_update(gchar **words, const char *node, const char *dampen)
+{
+    pcmk__node_attr_update_t *update = NULL;
+    char *value = strchr(words[0], '=');
+
+    if ((value == NULL) || (value == words[0])) {
+        fprintf(stderr, "Invalid update (expected NAME=VALUE): %s\n",
+                words[0]);
+        return NULL;
+    }
+    *value++ = '\0';
+
+    update = calloc(1, sizeof(pcmk__node_attr_update_t));
+    CRM_ASSERT(update != NULL);
+    update->name = words[0];
+    update->value = (*value == '\0')? NULL : value;
+    update->host = node;
+    update->dampen = dampen;
+
+    for (int i = 1; words[i] != NULL; i++) {
+        if (strncmp(words[i], "node=", 5) == 0) {
+            update->host = pcmk__node_attr_target(words[i] + 5);
+        } else if (strncmp(words[i], "delay=", 6) == 0) {
+            update->dampen = words[i] + 6;
+        } else {
+            fprintf(stderr, "Invalid option for %s: %s\n",
+                    update->name, words[i]);
+            free(update);
+            return NULL;
+        }
+    }
+    return update;
+}
+
+/*!
+ * \internal
+ * \brief Read updates from standard input and submit them in one request
+ *
+ * \param[in] attr_node     Default node for updates (or NULL for local node)
+ * \param[in] attr_section  Status or nodes
+ * \param[in] attr_set      ID of attribute set to use (or NULL to choose first)
+ * \param[in] attr_dampen   Default dampening for updates
+ * \param[in] attr_options  Bitmask of pcmk__node_attr_opts
+ *
+ * \return Standard Pacemaker return code
+ */
+static int
+do_update_many(const char *attr_node, const char *attr_section,
+               const char *attr_set, const char *attr_dampen, int attr_options)
+{
+    int rc = pcmk_rc_ok;
+    char *line = NULL;
+    size_t line_size = 0;
+    GList *lines = NULL;
+    GList *updates = NULL;
+    const char *node = pcmk__node_attr_target(attr_node);
+
+    while (getline(&line, &line_size, stdin) >= 0) {
+        gchar **words = NULL;
+        GError *error = NULL;
+        pcmk__node_attr_update_t *update = NULL;
+
+        if (strspn(line, " \t\r\n") == strlen(line)) {
+            continue; // Skip blank lines
+        }
+        if (!g_shell_parse_argv(line, NULL, &words, &error)) {
+            fprintf(stderr, "Invalid update line: %s\n", error->message);
+            g_clear_error(&error);
+            rc = EINVAL;
+            goto done;
+        }
+        lines = g_list_prepend(lines, words);
+
+        update = parse_update(words, node, attr_dampen);
+        if (update == NULL) {
+            rc = EINVAL;
+            goto done;
+        }
+        updates = g_list_append(updates, update);
+    }
+
+    if (updates == NULL) {
+        fprintf(stderr, "No updates given on standard input\n");
+        rc = EINVAL;
+        goto done;
+    }
+
+    rc = pcmk__node_attr_request_bulk(NULL, updates, attr_section, attr_set,
+                                      NULL, attr_options);
+    if (rc != pcmk_rc_ok) {
+        fprintf(stderr, "Could not update %d attribute%s: %s (%d)\n",
+                g_list_length(updates), pcmk__plural_s(g_list_length(updates)),
+                pcmk_rc_str(rc), rc);
+    }
+
+done:
+    free(line);
+    g_list_free_full(updates, free);
+    g_list_free_full(lines, (GDestroyNotify) g_strfreev);
+    return rc;
+}
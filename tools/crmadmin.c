@@ -51,6 +51,9 @@ static gboolean DO_RESOURCE = FALSE;
 static gboolean DO_ELECT_DC = FALSE;
 static gboolean DO_WHOIS_DC = FALSE;
 static gboolean DO_NODE_LIST = FALSE;
+static gboolean DO_JOB_LIMITS = FALSE;
+static gboolean DO_METRICS = FALSE;
+static gboolean AS_XML = FALSE;
 static gboolean BE_SILENT = FALSE;
 static gboolean DO_RESOURCE_LIST = FALSE;
 static const char *crmd_operation = NULL;
@@ -106,6 +109,30 @@ static pcmk__cli_option_t long_options[] = {
         "nodes", no_argument, NULL, 'N',
         "\tDisplay the uname of all member nodes", pcmk__option_default
     },
+    {
+        "job-limits", no_argument, NULL, 'J',
+        "Display the number of actions the DC will run at once on each node",
+        pcmk__option_default
+    },
+    {
+        "-spacer-", no_argument, NULL, '-',
+        "\n\tThe limit is the lower of what the node's load allows and what "
+            "the queue and execution times of its recent actions allow.\n",
+        pcmk__option_default
+    },
+    {
+        "metrics", no_argument, NULL, 'M',
+        "\tDisplay the DC's state machine and transition timings",
+        pcmk__option_default
+    },
+    {
+        "-spacer-", no_argument, NULL, '-',
+        "\n\tThis includes time spent in each controller state, the input "
+            "queue depth, scheduler response times, how long actions took "
+            "from initiation to confirmation, and why transitions were "
+            "aborted, all since the DC's controller started.\n",
+        pcmk__option_default
+    },
     {
         "election", no_argument, NULL, 'E',
         "(Advanced) Start an election for the cluster co-ordinator",
@@ -129,6 +156,10 @@ static pcmk__cli_option_t long_options[] = {
         "Time (in milliseconds) to wait before declaring the operation failed",
         pcmk__option_default
     },
+    {
+        "xml", no_argument, NULL, 'X',
+        "\tDisplay the result of --metrics as XML", pcmk__option_default
+    },
     {
         "bash-export", no_argument, NULL, 'B',
         "Create Bash export entries of the form 'export uname=uuid'\n",
@@ -208,6 +239,15 @@ main(int argc, char **argv)
             case 'N':
                 DO_NODE_LIST = TRUE;
                 break;
+            case 'J':
+                DO_JOB_LIMITS = TRUE;
+                break;
+            case 'M':
+                DO_METRICS = TRUE;
+                break;
+            case 'X':
+                AS_XML = TRUE;
+                break;
             case 'H':
                 DO_HEALTH = TRUE;
                 break;
@@ -301,6 +341,16 @@ do_work(void)
         sys_to = CRM_SYSTEM_DC;
         crmd_operation = CRM_OP_PING;
 
+    } else if (DO_JOB_LIMITS) {
+        dest_node = NULL;
+        sys_to = CRM_SYSTEM_DC;
+        crmd_operation = CRM_OP_JOB_LIMITS;
+
+    } else if (DO_METRICS) {
+        dest_node = NULL;
+        sys_to = CRM_SYSTEM_DC;
+        crmd_operation = CRM_OP_METRICS;
+
     } else if (DO_NODE_LIST) {
 
         cib_t *the_cib = cib_new();
@@ -435,6 +485,132 @@ validate_crm_message(xmlNode * msg, const char *sys, const char *uuid, const cha
     return TRUE;
 }
 
+static void
+print_job_limits(xmlNode *reply)
+{
+    xmlNode *limits = get_message_xml(reply, F_CRM_DATA);
+
+    printf("Job limits on %s:\n",
+           crm_str(crm_element_value(reply, F_CRM_HOST_FROM)));
+    for (xmlNode *node = first_named_child(limits, XML_CIB_TAG_NODE);
+         node != NULL; node = crm_next_same_xml(node)) {
+
+        int adaptive = 0;
+
+        crm_element_value_int(node, PCMK__XA_ADAPTIVE_LIMIT, &adaptive);
+        if (BE_SILENT) {
+            printf("%s=%s\n", crm_str(crm_element_value(node, XML_ATTR_UNAME)),
+                   crm_str(crm_element_value(node, PCMK__XA_JOB_LIMIT)));
+
+        } else if (adaptive > 0) {
+            printf(" %s: %s (node maximum %s with %s load; latency limit %d "
+                   "lowered %s times; last queue time %sms, exec time %sms)\n",
+                   crm_str(crm_element_value(node, XML_ATTR_UNAME)),
+                   crm_str(crm_element_value(node, PCMK__XA_JOB_LIMIT)),
+                   crm_str(crm_element_value(node, PCMK__XA_JOB_MAX)),
+                   crm_str(crm_element_value(node, PCMK__XA_LOAD)), adaptive,
+                   crm_str(crm_element_value(node, PCMK__XA_LIMIT_DECREASES)),
+                   crm_str(crm_element_value(node, XML_RSC_OP_T_QUEUE)),
+                   crm_str(crm_element_value(node, XML_RSC_OP_T_EXEC)));
+
+        } else {
+            printf(" %s: %s (node maximum %s with %s load; no action "
+                   "results yet)\n",
+                   crm_str(crm_element_value(node, XML_ATTR_UNAME)),
+                   crm_str(crm_element_value(node, PCMK__XA_JOB_LIMIT)),
+                   crm_str(crm_element_value(node, PCMK__XA_JOB_MAX)),
+                   crm_str(crm_element_value(node, PCMK__XA_LOAD)));
+        }
+    }
+}
+
+static void
+print_latency(const char *prefix, xmlNode *xml)
+{
+    int count = 0;
+    long long total_ms = 0;
+
+    crm_element_value_int(xml, PCMK__XA_COUNT, &count);
+    crm_element_value_ll(xml, PCMK__XA_TOTAL_MS, &total_ms);
+    if (count > 0) {
+        printf(" %s: %d (average %lldms, maximum %sms, last %sms)\n",
+               prefix, count, total_ms / count,
+               crm_str(crm_element_value(xml, PCMK__XA_MAX_MS)),
+               crm_str(crm_element_value(xml, PCMK__XA_LAST_MS)));
+    } else {
+        printf(" %s: none\n", prefix);
+    }
+}
+
+static void
+print_metrics(xmlNode *reply)
+{
+    xmlNode *metrics = get_message_xml(reply, F_CRM_DATA);
+    xmlNode *child = NULL;
+
+    if (AS_XML) {
+        char *buffer = dump_xml_formatted(metrics);
+
+        printf("%s", buffer);
+        free(buffer);
+        return;
+    }
+
+    printf("Controller metrics on %s:\n",
+           crm_str(crm_element_value(reply, F_CRM_HOST_FROM)));
+
+    child = first_named_child(metrics, PCMK__XE_FSA);
+    printf(" Current state: %s for %sms (input queue %s, maximum %s)\n",
+           crm_str(crm_element_value(child, XML_PING_ATTR_CRMDSTATE)),
+           crm_str(crm_element_value(child, PCMK__XA_CURRENT_MS)),
+           crm_str(crm_element_value(child, PCMK__XA_QUEUE_DEPTH)),
+           crm_str(crm_element_value(child, PCMK__XA_QUEUE_MAX)));
+    for (xmlNode *state = first_named_child(child, PCMK__XE_FSA_STATE);
+         state != NULL; state = crm_next_same_xml(state)) {
+
+        const char *name = crm_element_value(state, XML_NVPAIR_ATTR_NAME);
+        char *prefix = crm_strdup_printf("Time in %s", crm_str(name));
+
+        print_latency(prefix, state);
+        free(prefix);
+    }
+
+    print_latency("Scheduler responses",
+                  first_named_child(metrics, PCMK__XE_SCHEDULER));
+
+    for (child = first_named_child(metrics, PCMK__XE_ACTION_LATENCY);
+         child != NULL; child = crm_next_same_xml(child)) {
+
+        const char *task = crm_element_value(child, PCMK__XA_TASK);
+        char *prefix = crm_strdup_printf("%s actions", crm_str(task));
+
+        print_latency(prefix, child);
+        free(prefix);
+        for (xmlNode *bucket = first_named_child(child,
+                                                 PCMK__XE_LATENCY_BUCKET);
+             bucket != NULL; bucket = crm_next_same_xml(bucket)) {
+
+            const char *upper = crm_element_value(bucket, PCMK__XA_UPPER_MS);
+
+            if (upper != NULL) {
+                printf("   under %sms: %s\n", upper,
+                       crm_str(crm_element_value(bucket, PCMK__XA_COUNT)));
+            } else {
+                printf("   longer: %s\n",
+                       crm_str(crm_element_value(bucket, PCMK__XA_COUNT)));
+            }
+        }
+    }
+
+    for (child = first_named_child(metrics, PCMK__XE_TRANSITION_ABORT);
+         child != NULL; child = crm_next_same_xml(child)) {
+
+        printf(" Transitions aborted by \"%s\": %s\n",
+               crm_str(crm_element_value(child, PCMK__XA_REASON)),
+               crm_str(crm_element_value(child, PCMK__XA_COUNT)));
+    }
+}
+
 int
 admin_msg_callback(const char *buffer, ssize_t length, gpointer userdata)
 {
@@ -473,6 +649,12 @@ admin_msg_callback(const char *buffer, ssize_t length, gpointer userdata)
             fprintf(stderr, "%s\n", dc);
         }
         crm_exit(CRM_EX_OK);
+
+    } else if (DO_JOB_LIMITS) {
+        print_job_limits(xml);
+
+    } else if (DO_METRICS) {
+        print_metrics(xml);
     }
 
     free_xml(xml);
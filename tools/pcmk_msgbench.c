@@ -0,0 +1,641 @@
+/*
+ * Copyright 2020 the Pacemaker project contributors
+ *
+ * The version control history for this file may have further details.
+ *
+ * This source code is licensed under the GNU General Public License version 2
+ * or later (GPLv2+) WITHOUT ANY WARRANTY.
+ */
+
+#include <crm_internal.h>
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <crm/crm.h>
+#include <crm/lrmd.h>
+#include <crm/msg_xml.h>
+#include <crm/common/cmdline_internal.h>
+#include <crm/common/ipc.h>
+#include <crm/common/ipc_internal.h>
+#include <crm/common/ipcs_internal.h>
+#include <crm/common/mainloop.h>
+#include <crm/common/xml.h>
+
+#if SUPPORT_COROSYNC
+#  include <crm/cluster.h>
+#  include <crm/cluster/internal.h>
+#endif
+
+#define SUMMARY "measure throughput and latency of Pacemaker's messaging layer"
+
+#define BENCH_TIMEOUT_MS 5000   // Give up on an IPC reply after this long
+
+struct {
+    gint size;
+    gint count;
+    gint clients;
+    gchar *mode;
+    gboolean binary;
+} options = {
+    .size = 1024,
+    .count = 10000,
+    .clients = 1,
+    .mode = NULL,
+    .binary = FALSE,
+};
+
+static GOptionEntry entries[] = {
+    { "size", 's', 0, G_OPTION_ARG_INT, &options.size,
+      "Approximate size of each message in bytes (default 1024)",
+      "BYTES" },
+    { "count", 'n', 0, G_OPTION_ARG_INT, &options.count,
+      "Number of messages to send per client (default 10000)",
+      "COUNT" },
+    { "clients", 'c', 0, G_OPTION_ARG_INT, &options.clients,
+      "Number of concurrent IPC clients (default 1)",
+      "COUNT" },
+    { "mode", 'm', 0, G_OPTION_ARG_STRING, &options.mode,
+      "What to measure: \"ipc\", \"cpg\", or \"all\" (default)",
+      "MODE" },
+    { "binary", 'b', G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &options.binary,
+      "Let IPC clients accept the binary message encoding",
+      NULL },
+
+    { NULL }
+};
+
+// Results reported by each IPC client process to the parent
+typedef struct bench_result_s {
+    uint64_t start_ns;      // When the first message was sent
+    uint64_t end_ns;        // When the last reply was received
+    uint64_t bytes;         // Total size of replies received
+    uint32_t sent;          // Number of latency samples that follow
+    uint32_t errors;        // Number of failed sends
+} bench_result_t;
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+static int
+compare_samples(const void *a, const void *b)
+{
+    uint64_t first = *(const uint64_t *) a;
+    uint64_t second = *(const uint64_t *) b;
+
+    return (first > second) - (first < second);
+}
+
+/*!
+ * \internal
+ * \brief Print message rate and latency percentiles for a set of samples
+ *
+ * \param[in]     label    What was measured
+ * \param[in,out] samples  Latency of each message in nanoseconds (will be
+ *                         sorted)
+ * \param[in]     n        Number of entries in \p samples
+ * \param[in]     wall_ns  Elapsed time for all messages
+ * \param[in]     bytes    Total bytes on the wire for all messages
+ */
+static void
+report(const char *label, uint64_t *samples, size_t n, uint64_t wall_ns,
+       uint64_t bytes)
+{
+    if (n == 0) {
+        printf("%-22s no messages sent\n", label);
+        return;
+    }
+    qsort(samples, n, sizeof(uint64_t), compare_samples);
+    printf("%-22s %10.0f msgs/s  p50 %8.1fus  p99 %8.1fus  %8llu bytes/msg\n",
+           label, (wall_ns? (n * 1e9 / wall_ns) : 0.0),
+           samples[n / 2] / 1e3, samples[QB_MIN(n - 1, (n * 99) / 100)] / 1e3,
+           (unsigned long long) (bytes / n));
+}
+
+/*!
+ * \internal
+ * \brief Print the peak resident set size so far
+ *
+ * \param[in] label  What was measured
+ * \param[in] who    RUSAGE_SELF for this process, or RUSAGE_CHILDREN for the
+ *                   largest child process that has been waited for
+ */
+static void
+report_rss(const char *label, int who)
+{
+    struct rusage usage;
+
+    if (getrusage(who, &usage) < 0) {
+        printf("%-22s unknown: %s\n", label, pcmk_rc_str(errno));
+        return;
+    }
+    // Linux reports ru_maxrss in kilobytes
+    printf("%-22s %10ld KiB peak RSS\n", label, usage.ru_maxrss);
+}
+
+/*!
+ * \internal
+ * \brief Create a test message resembling an operation result
+ *
+ * \param[in] size  Approximate size of the message when serialized as text
+ *
+ * \return Newly allocated XML
+ */
+static xmlNode *
+bench_message(int size)
+{
+    xmlNode *msg = create_xml_node(NULL, T_LRMD);
+    xmlNode *attrs = NULL;
+    int len = 0;
+
+    crm_xml_add(msg, F_TYPE, T_LRMD);
+    crm_xml_add(msg, F_LRMD_OPERATION, LRMD_OP_RSC_EXEC);
+    crm_xml_add(msg, F_LRMD_RSC_ID, "bench-rsc");
+    crm_xml_add(msg, F_LRMD_RSC_ACTION, "monitor");
+    crm_xml_add_int(msg, F_LRMD_CALLID, 1);
+    attrs = create_xml_node(msg, XML_TAG_ATTRS);
+
+    for (int i = 0; len < size; i++) {
+        char *name = crm_strdup_printf("bench-attr-%d", i);
+        char *value = crm_strdup_printf("value-%d-%x", i, (i * 2654435761U));
+
+        crm_xml_add(attrs, name, value);
+        len += strlen(name) + strlen(value) + 4;
+        free(name);
+        free(value);
+    }
+    return msg;
+}
+
+/*!
+ * \internal
+ * \brief Report how long it takes to compress a message's text
+ *
+ * \param[in] msg  Message to compress
+ */
+static void
+report_compression(xmlNode *msg)
+{
+    char *text = dump_xml_unformatted(msg);
+    unsigned int length = strlen(text) + 1;
+    unsigned int bound = pcmk__compress_bound(length);
+    unsigned int compressed = bound;
+    char *buffer = malloc(bound);
+    int iterations = QB_MAX(1, QB_MIN(options.count, 100));
+    uint64_t start = 0;
+    uint64_t elapsed = 0;
+    int rc = pcmk_rc_ok;
+
+    CRM_ASSERT(buffer != NULL);
+    start = now_ns();
+    for (int i = 0; (i < iterations) && (rc == pcmk_rc_ok); i++) {
+        compressed = bound;
+        rc = pcmk__compress_to_buffer(text, length, buffer, &compressed);
+    }
+    elapsed = now_ns() - start;
+
+    if (rc == pcmk_rc_ok) {
+        printf("%-22s %8.1fus per message  %u -> %u bytes%s\n", "compression",
+               elapsed / 1e3 / iterations, length, compressed,
+               ((length < CRM_BZ2_THRESHOLD)? " (below threshold)" : ""));
+        report_rss("compression memory", RUSAGE_SELF);
+    } else {
+        printf("%-22s failed: %s\n", "compression", pcmk_rc_str(rc));
+    }
+    free(buffer);
+    free(text);
+}
+
+/*
+ * Stand-in IPC server, which echoes each request back as the reply
+ */
+
+static GMainLoop *server_loop = NULL;
+
+static int32_t
+bench_ipc_accept(qb_ipcs_connection_t *c, uid_t uid, gid_t gid)
+{
+    return (pcmk__new_client(c, uid, gid) == NULL)? -EIO : 0;
+}
+
+static int32_t
+bench_ipc_dispatch(qb_ipcs_connection_t *qbc, void *data, size_t size)
+{
+    uint32_t id = 0;
+    uint32_t flags = 0;
+    pcmk__client_t *c = pcmk__find_client(qbc);
+    xmlNode *msg = pcmk__client_data2xml(c, data, &id, &flags);
+
+    if (msg == NULL) {
+        pcmk__ipc_send_ack(c, id, flags, "nack");
+        return 0;
+    }
+    if (pcmk__ipc_send_xml(c, id, msg, crm_ipc_flags_none) != pcmk_rc_ok) {
+        crm_warn("Could not reply to benchmark client %u", c->pid);
+    }
+    free_xml(msg);
+    return 0;
+}
+
+static int32_t
+bench_ipc_closed(qb_ipcs_connection_t *c)
+{
+    pcmk__client_t *client = pcmk__find_client(c);
+
+    if (client != NULL) {
+        pcmk__free_client(client);
+    }
+    return 0;
+}
+
+static void
+bench_ipc_destroy(qb_ipcs_connection_t *c)
+{
+    bench_ipc_closed(c);
+}
+
+static struct qb_ipcs_service_handlers bench_ipc_callbacks = {
+    .connection_accept = bench_ipc_accept,
+    .connection_created = NULL,
+    .msg_process = bench_ipc_dispatch,
+    .connection_closed = bench_ipc_closed,
+    .connection_destroyed = bench_ipc_destroy
+};
+
+static void
+bench_server_shutdown(int nsig)
+{
+    g_main_loop_quit(server_loop);
+}
+
+/*!
+ * \internal
+ * \brief Run the stand-in server until terminated (in a child process)
+ *
+ * \param[in] name      IPC server name
+ * \param[in] ready_fd  File descriptor to write to once accepting connections
+ */
+static void
+run_server(const char *name, int ready_fd)
+{
+    qb_ipcs_service_t *ipcs = NULL;
+    char ready = 1;
+
+    mainloop_add_signal(SIGTERM, bench_server_shutdown);
+    ipcs = mainloop_add_ipc_server(name, QB_IPC_SHM, &bench_ipc_callbacks);
+    if (ipcs == NULL) {
+        crm_err("Could not start benchmark IPC server %s", name);
+        _exit(CRM_EX_FATAL);
+    }
+
+    server_loop = g_main_loop_new(NULL, FALSE);
+    if (write(ready_fd, &ready, 1) != 1) {
+        _exit(CRM_EX_FATAL);
+    }
+    close(ready_fd);
+    g_main_loop_run(server_loop);
+
+    pcmk__drop_all_clients(ipcs);
+    mainloop_del_ipc_server(ipcs);
+    _exit(CRM_EX_OK);
+}
+
+/*!
+ * \internal
+ * \brief Send messages to the stand-in server (in a child process)
+ *
+ * \param[in] name       IPC server name
+ * \param[in] msg        Message to send
+ * \param[in] result_fd  File descriptor to write results to
+ */
+static void
+run_client(const char *name, xmlNode *msg, int result_fd)
+{
+    crm_ipc_t *ipc = crm_ipc_new(name, 0);
+    bench_result_t result = { 0, };
+    uint64_t *samples = calloc(options.count, sizeof(uint64_t));
+
+    CRM_ASSERT(samples != NULL);
+    if ((ipc == NULL) || !crm_ipc_connect(ipc)) {
+        crm_err("Could not connect to benchmark IPC server %s", name);
+        _exit(CRM_EX_UNAVAILABLE);
+    }
+    if (options.binary) {
+        pcmk__ipc_accept_binary(ipc);
+    }
+
+    result.start_ns = now_ns();
+    for (int i = 0; i < options.count; i++) {
+        xmlNode *reply = NULL;
+        uint64_t sent_ns = now_ns();
+        int rc = crm_ipc_send(ipc, msg, crm_ipc_client_response,
+                              BENCH_TIMEOUT_MS, &reply);
+
+        if (rc <= 0) {
+            result.errors++;
+        } else {
+            samples[result.sent++] = now_ns() - sent_ns;
+            result.bytes += rc;
+        }
+        free_xml(reply);
+    }
+    result.end_ns = now_ns();
+
+    crm_ipc_close(ipc);
+    crm_ipc_destroy(ipc);
+
+    if ((write(result_fd, &result, sizeof(result)) != sizeof(result))
+        || (write(result_fd, samples, result.sent * sizeof(uint64_t))
+            != (ssize_t) (result.sent * sizeof(uint64_t)))) {
+        _exit(CRM_EX_IOERR);
+    }
+    _exit(CRM_EX_OK);
+}
+
+static bool
+read_all(int fd, void *buffer, size_t length)
+{
+    char *next = buffer;
+
+    while (length > 0) {
+        ssize_t rc = read(fd, next, length);
+
+        if (rc <= 0) {
+            if ((rc < 0) && (errno == EINTR)) {
+                continue;
+            }
+            return FALSE;
+        }
+        next += rc;
+        length -= rc;
+    }
+    return TRUE;
+}
+
+/*!
+ * \internal
+ * \brief Measure round trips through crm_ipc_send() and pcmk__ipc_send_xml()
+ *
+ * \param[in] msg  Message to send
+ *
+ * \return Standard Pacemaker return code
+ */
+static int
+bench_ipc(xmlNode *msg)
+{
+    char *name = crm_strdup_printf("pcmk-msgbench-%lld", (long long) getpid());
+    int ready_pipe[2];
+    pid_t server = 0;
+    pid_t *clients = NULL;
+    int *result_fds = NULL;
+    uint64_t *samples = NULL;
+    size_t n_samples = 0;
+    uint64_t first_ns = UINT64_MAX;
+    uint64_t last_ns = 0;
+    uint64_t bytes = 0;
+    unsigned int errors = 0;
+    char ready = 0;
+    int rc = pcmk_rc_ok;
+
+    if (pipe(ready_pipe) < 0) {
+        rc = errno;
+        goto done;
+    }
+    server = fork();
+    if (server < 0) {
+        rc = errno;
+        goto done;
+    } else if (server == 0) {
+        close(ready_pipe[0]);
+        run_server(name, ready_pipe[1]);
+    }
+    close(ready_pipe[1]);
+    if (!read_all(ready_pipe[0], &ready, 1)) {
+        close(ready_pipe[0]);
+        rc = ECONNREFUSED;
+        goto done;
+    }
+    close(ready_pipe[0]);
+
+    clients = calloc(options.clients, sizeof(pid_t));
+    result_fds = calloc(options.clients, sizeof(int));
+    samples = calloc((size_t) options.clients * options.count,
+                     sizeof(uint64_t));
+    CRM_ASSERT((clients != NULL) && (result_fds != NULL) && (samples != NULL));
+
+    for (int i = 0; i < options.clients; i++) {
+        int result_pipe[2];
+
+        if (pipe(result_pipe) < 0) {
+            rc = errno;
+            break;
+        }
+        clients[i] = fork();
+        if (clients[i] < 0) {
+            rc = errno;
+            close(result_pipe[0]);
+            close(result_pipe[1]);
+            break;
+        } else if (clients[i] == 0) {
+            close(result_pipe[0]);
+            run_client(name, msg, result_pipe[1]);
+        }
+        close(result_pipe[1]);
+        result_fds[i] = result_pipe[0];
+    }
+
+    for (int i = 0; (i < options.clients) && (clients[i] > 0); i++) {
+        bench_result_t result;
+
+        if (read_all(result_fds[i], &result, sizeof(result))
+            && (result.sent <= (uint32_t) options.count)
+            && read_all(result_fds[i], samples + n_samples,
+                        result.sent * sizeof(uint64_t))) {
+            n_samples += result.sent;
+            bytes += result.bytes;
+            errors += result.errors;
+            first_ns = QB_MIN(first_ns, result.start_ns);
+            last_ns = QB_MAX(last_ns, result.end_ns);
+        } else {
+            errors += options.count;
+        }
+        close(result_fds[i]);
+        waitpid(clients[i], NULL, 0);
+    }
+
+    report("ipc round trip", samples, n_samples,
+           ((last_ns > first_ns)? (last_ns - first_ns) : 0), bytes);
+    if (errors > 0) {
+        printf("%-22s %u\n", "ipc errors", errors);
+    }
+
+done:
+    if (server > 0) {
+        kill(server, SIGTERM);
+        waitpid(server, NULL, 0);
+    }
+    if (rc == pcmk_rc_ok) {
+        // Clients and server have all been waited for by now
+        report_rss("ipc memory", RUSAGE_CHILDREN);
+    }
+    free(clients);
+    free(result_fds);
+    free(samples);
+    free(name);
+    return rc;
+}
+
+#if SUPPORT_COROSYNC
+/*!
+ * \internal
+ * \brief Measure the cost of preparing messages in send_cluster_text()
+ *
+ * Without a CPG connection, messages stay in the library's send queue, which
+ * stands in for corosync here: each message is removed from the queue as soon
+ * as it is prepared, and its size is counted as bytes on the wire. Batching
+ * (PCMK_cpg_batch_delay) needs a main loop to flush, so it is not measured.
+ *
+ * \param[in] msg  Message to send
+ *
+ * \return Standard Pacemaker return code
+ */
+static int
+bench_cpg(xmlNode *msg)
+{
+    char *text = dump_xml_unformatted(msg);
+    uint64_t *samples = calloc(options.count, sizeof(uint64_t));
+    uint64_t start_ns = 0;
+    uint64_t bytes = 0;
+    size_t n = 0;
+
+    CRM_ASSERT((text != NULL) && (samples != NULL));
+
+    // Look up the local node name up front, so it is not timed
+    get_local_node_name();
+
+    start_ns = now_ns();
+    for (int i = 0; i < options.count; i++) {
+        uint64_t sent_ns = now_ns();
+
+        send_cluster_text(crm_class_cluster, text, TRUE, NULL, crm_msg_attrd);
+        samples[n++] = now_ns() - sent_ns;
+
+        bytes += pcmk__cpg_drain_queue();
+    }
+    report("cpg send", samples, n, now_ns() - start_ns, bytes);
+    report_rss("cpg memory", RUSAGE_SELF);
+
+    free(samples);
+    free(text);
+    return pcmk_rc_ok;
+}
+#endif
+
+static GOptionContext *
+build_arg_context(pcmk__common_args_t *args) {
+    GOptionContext *context = NULL;
+
+    const char *description = "This tool is intended for developers. Its "
+                              "interface and output may change with any "
+                              "version of pacemaker.";
+
+    context = pcmk__build_arg_context(args, NULL, NULL);
+    g_option_context_set_description(context, description);
+    g_option_context_add_main_entries(context, entries, NULL);
+    return context;
+}
+
+int
+main(int argc, char **argv)
+{
+    xmlNode *msg = NULL;
+    int rc = pcmk_rc_ok;
+    crm_exit_t exit_code = CRM_EX_OK;
+
+    pcmk__common_args_t *args = pcmk__new_common_args(SUMMARY);
+
+    GError *error = NULL;
+    GOptionContext *context = NULL;
+    gchar **processed_args = NULL;
+
+    context = build_arg_context(args);
+
+    crm_log_cli_init("pcmk_msgbench");
+
+    processed_args = pcmk__cmdline_preproc(argv, "scnm");
+
+    if (!g_option_context_parse_strv(context, &processed_args, &error)) {
+        fprintf(stderr, "%s: %s\n", g_get_prgname(), error->message);
+        exit_code = CRM_EX_USAGE;
+        goto bail;
+    }
+
+    for (int i = 0; i < args->verbosity; i++) {
+        crm_bump_log_level(argc, argv);
+    }
+
+    if (args->version) {
+        pcmk__cli_help('v', CRM_EX_USAGE);
+    }
+
+    if ((options.size <= 0) || (options.count <= 0) || (options.clients <= 0)
+        || ((options.mode != NULL) && safe_str_neq(options.mode, "ipc")
+            && safe_str_neq(options.mode, "cpg")
+            && safe_str_neq(options.mode, "all"))) {
+        char *help = g_option_context_get_help(context, TRUE, NULL);
+
+        fprintf(stderr, "%s", help);
+        g_free(help);
+        exit_code = CRM_EX_USAGE;
+        goto bail;
+    }
+
+    msg = bench_message(options.size);
+    printf("%d client(s), %d message(s) each, %d-byte messages\n",
+           options.clients, options.count, options.size);
+    report_compression(msg);
+
+    if ((options.mode == NULL) || safe_str_neq(options.mode, "cpg")) {
+        rc = bench_ipc(msg);
+        if (rc != pcmk_rc_ok) {
+            fprintf(stderr, "IPC benchmark failed: %s\n", pcmk_rc_str(rc));
+            exit_code = pcmk_rc2exitc(rc);
+            goto bail;
+        }
+    }
+
+    if ((options.mode == NULL) || safe_str_neq(options.mode, "ipc")) {
+#if SUPPORT_COROSYNC
+        rc = bench_cpg(msg);
+        if (rc != pcmk_rc_ok) {
+            fprintf(stderr, "CPG benchmark failed: %s\n", pcmk_rc_str(rc));
+            exit_code = pcmk_rc2exitc(rc);
+            goto bail;
+        }
+#else
+        printf("%-22s not supported by this build\n", "cpg send");
+#endif
+    }
+
+bail:
+    free_xml(msg);
+    g_free(options.mode);
+    g_strfreev(processed_args);
+    g_clear_error(&error);
+    pcmk__free_arg_context(context);
+    crm_exit(exit_code);
+}